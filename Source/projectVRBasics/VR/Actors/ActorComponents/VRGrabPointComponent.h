@@ -0,0 +1,16 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "VRGrabPointComponent.generated.h"
+
+/**
+ * Point of an IHandInteractable actor that hands measure grab distance to. Without it actor location is used (see FVRGrabCandidateTable)
+ */
+UCLASS(ClassGroup = VR, meta = (BlueprintSpawnableComponent))
+class PROJECTVRBASICS_API UVRGrabPointComponent : public USceneComponent
+{
+	GENERATED_BODY()
+};
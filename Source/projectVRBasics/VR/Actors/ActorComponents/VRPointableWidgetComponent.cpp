@@ -0,0 +1,197 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRPointableWidgetComponent.h"
+
+#include "Blueprint/UserWidget.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/Button.h"
+#include "Components/PanelWidget.h"
+#include "Engine/World.h"
+
+#include "../VirtualRealityMotionController.h"
+#include "../../Subsystems/VRWidgetRedrawBudget.h"
+
+
+void UVRPointableWidgetComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bBudgetRedraw) SetManuallyRedraw(true);
+}
+
+void UVRPointableWidgetComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	if (bBudgetRedraw) RequestBudgetedRedraw(); // Before Super draws the widget
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+void UVRPointableWidgetComponent::RequestBudgetedRedraw()
+{
+	const bool bPointed = Pointers.Num() > 0;
+	const double Time = GetWorld()->GetTimeSeconds();
+
+	const bool bRedrawTimeCame = UnpointedRedrawRate > 0.f && Time - LastRedrawTime >= 1.f / UnpointedRedrawRate;
+	if (!bPointed && !bContentChanged && !bRedrawTimeCame) return;
+
+	UVRWidgetRedrawBudget* RedrawBudget = GetWorld()->GetSubsystem<UVRWidgetRedrawBudget>();
+	if (RedrawBudget && !RedrawBudget->TryConsumeRedraw(bPointed)) return; // Waits for next frame
+
+	RequestRedraw();
+	LastRedrawTime = Time;
+	bContentChanged = false;
+}
+
+void UVRPointableWidgetComponent::UpdatePointer(AVirtualRealityMotionController* MotionController, const FVector& WorldHitLocation)
+{
+	FPointerState* Pointer = FindPointer(MotionController);
+	if (!Pointer)
+	{
+		Pointer = &Pointers.AddDefaulted_GetRef();
+		Pointer->MotionController = MotionController;
+	}
+
+	if (bHitGridDirty || GetWorld()->GetTimeSeconds() - HitGridBuildTime > HitGridRefreshInterval) RebuildHitGrid();
+
+	FVector2D WidgetLocation;
+	GetLocalHitLocation(WorldHitLocation, WidgetLocation);
+
+	UWidget* Element = FindElementAt(WidgetLocation);
+	UWidget* PreviousElement = Pointer->HoveredElement.Get();
+	if (Element == PreviousElement) return;
+
+	Pointer->HoveredElement = Element;
+	if (PreviousElement) OnElementUnhovered.Broadcast(PreviousElement, MotionController);
+	if (Element) OnElementHovered.Broadcast(Element, MotionController);
+}
+
+void UVRPointableWidgetComponent::EndPointer(AVirtualRealityMotionController* MotionController)
+{
+	const int32 PointerIndex = Pointers.IndexOfByPredicate([MotionController](const FPointerState& Pointer) { return Pointer.MotionController.Get() == MotionController; });
+	if (PointerIndex == INDEX_NONE) return;
+
+	UWidget* HoveredElement = Pointers[PointerIndex].HoveredElement.Get();
+	Pointers.RemoveAtSwap(PointerIndex);
+	bContentChanged = true; // Last frame drawn while pointed may show hover state
+
+	if (HoveredElement) OnElementUnhovered.Broadcast(HoveredElement, MotionController);
+}
+
+void UVRPointableWidgetComponent::PressPointer(AVirtualRealityMotionController* MotionController)
+{
+	FPointerState* Pointer = FindPointer(MotionController);
+	if (!Pointer || !Pointer->HoveredElement.IsValid()) return;
+
+	Pointer->PressedElement = Pointer->HoveredElement;
+	OnElementPressed.Broadcast(Pointer->PressedElement.Get(), MotionController);
+}
+
+void UVRPointableWidgetComponent::ReleasePointer(AVirtualRealityMotionController* MotionController)
+{
+	FPointerState* Pointer = FindPointer(MotionController);
+	if (!Pointer || !Pointer->PressedElement.IsValid()) return;
+
+	UWidget* PressedElement = Pointer->PressedElement.Get();
+	Pointer->PressedElement.Reset();
+	OnElementReleased.Broadcast(PressedElement, MotionController);
+
+	if (!bClickButtons || PressedElement != Pointer->HoveredElement.Get()) return; // Pointer left the element while pressed
+
+	if (UButton* Button = Cast<UButton>(PressedElement)) Button->OnClicked.Broadcast();
+}
+
+UWidget* UVRPointableWidgetComponent::GetHoveredElement(AVirtualRealityMotionController* MotionController) const
+{
+	const FPointerState* Pointer = FindPointer(MotionController);
+	return Pointer ? Pointer->HoveredElement.Get() : nullptr;
+}
+
+void UVRPointableWidgetComponent::RebuildHitGrid()
+{
+	HitElements.Reset();
+	HitGridCells.Reset();
+	HitGridSize = GetCurrentDrawSize();
+	HitGridBuildTime = GetWorld()->GetTimeSeconds();
+
+	UUserWidget* UserWidget = GetUserWidgetObject();
+	if (!UserWidget || !UserWidget->WidgetTree || HitGridSize.X <= 0.f || HitGridSize.Y <= 0.f) return;
+
+	// Geometry is known only after widget was painted once
+	const FGeometry& RootGeometry = UserWidget->GetCachedGeometry();
+	if (RootGeometry.GetLocalSize().IsNearlyZero()) return;
+
+	bHitGridDirty = false;
+
+	// Parents are visited before their children, so later elements are painted on top
+	UserWidget->WidgetTree->ForEachWidget([this, &RootGeometry](UWidget* Widget)
+	{
+		if (!Widget->IsInteractable() || !Widget->IsVisible() || !Widget->GetIsEnabled()) return;
+
+		const FGeometry& Geometry = Widget->GetCachedGeometry();
+		FBox2D Box(RootGeometry.AbsoluteToLocal(Geometry.GetAbsolutePosition()), RootGeometry.AbsoluteToLocal(Geometry.GetAbsolutePosition() + Geometry.GetAbsoluteSize()));
+
+		// Scrolled out parts of lists are clipped by their panels
+		for (UPanelWidget* Parent = Widget->GetParent(); Parent && Box.bIsValid; Parent = Parent->GetParent())
+		{
+			if (Parent->Clipping == EWidgetClipping::Inherit) continue;
+
+			const FGeometry& ParentGeometry = Parent->GetCachedGeometry();
+			const FBox2D ParentBox(RootGeometry.AbsoluteToLocal(ParentGeometry.GetAbsolutePosition()), RootGeometry.AbsoluteToLocal(ParentGeometry.GetAbsolutePosition() + ParentGeometry.GetAbsoluteSize()));
+			Box = Box.Overlap(ParentBox);
+		}
+
+		if (!Box.bIsValid || Box.GetArea() <= 0.f) return;
+
+		FHitElement& HitElement = HitElements.AddDefaulted_GetRef();
+		HitElement.Widget = Widget;
+		HitElement.Box = Box;
+	});
+
+	const int32 Resolution = FMath::Max(HitGridResolution, 1);
+	const FVector2D CellSize = HitGridSize / Resolution;
+	HitGridCells.SetNum(Resolution * Resolution);
+
+	for (int32 ElementIndex = 0; ElementIndex < HitElements.Num(); ++ElementIndex)
+	{
+		const FBox2D& Box = HitElements[ElementIndex].Box;
+		const int32 MinX = FMath::Clamp(FMath::FloorToInt(Box.Min.X / CellSize.X), 0, Resolution - 1);
+		const int32 MaxX = FMath::Clamp(FMath::FloorToInt(Box.Max.X / CellSize.X), 0, Resolution - 1);
+		const int32 MinY = FMath::Clamp(FMath::FloorToInt(Box.Min.Y / CellSize.Y), 0, Resolution - 1);
+		const int32 MaxY = FMath::Clamp(FMath::FloorToInt(Box.Max.Y / CellSize.Y), 0, Resolution - 1);
+
+		for (int32 Y = MinY; Y <= MaxY; ++Y)
+		{
+			for (int32 X = MinX; X <= MaxX; ++X) HitGridCells[Y * Resolution + X].Add(ElementIndex);
+		}
+	}
+}
+
+UWidget* UVRPointableWidgetComponent::FindElementAt(const FVector2D& WidgetLocation) const
+{
+	if (HitGridCells.Num() == 0) return nullptr;
+	if (WidgetLocation.X < 0.f || WidgetLocation.Y < 0.f || WidgetLocation.X >= HitGridSize.X || WidgetLocation.Y >= HitGridSize.Y) return nullptr;
+
+	const int32 Resolution = FMath::Max(HitGridResolution, 1);
+	const int32 X = FMath::Min(FMath::FloorToInt(WidgetLocation.X / HitGridSize.X * Resolution), Resolution - 1);
+	const int32 Y = FMath::Min(FMath::FloorToInt(WidgetLocation.Y / HitGridSize.Y * Resolution), Resolution - 1);
+
+	const TArray<int32, TInlineAllocator<4>>& Cell = HitGridCells[Y * Resolution + X];
+	for (int32 Index = Cell.Num() - 1; Index >= 0; --Index) // Topmost first
+	{
+		const FHitElement& HitElement = HitElements[Cell[Index]];
+		if (HitElement.Box.IsInside(WidgetLocation) && HitElement.Widget.IsValid()) return HitElement.Widget.Get();
+	}
+
+	return nullptr;
+}
+
+UVRPointableWidgetComponent::FPointerState* UVRPointableWidgetComponent::FindPointer(const AVirtualRealityMotionController* MotionController)
+{
+	return Pointers.FindByPredicate([MotionController](const FPointerState& Pointer) { return Pointer.MotionController.Get() == MotionController; });
+}
+
+const UVRPointableWidgetComponent::FPointerState* UVRPointableWidgetComponent::FindPointer(const AVirtualRealityMotionController* MotionController) const
+{
+	return Pointers.FindByPredicate([MotionController](const FPointerState& Pointer) { return Pointer.MotionController.Get() == MotionController; });
+}
@@ -0,0 +1,106 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/WidgetComponent.h"
+#include "VRPointableWidgetComponent.generated.h"
+
+class UWidget;
+class AVirtualRealityMotionController;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FVRPointedWidgetElementEvent, UWidget*, Element, AVirtualRealityMotionController*, MotionController);
+
+/**
+ * World-space widget that is pointed at by motion controllers natively. Pointing hit is mapped to widget space and looked up in a cached grid of interactable elements (buttons, sliders, check boxes),
+ * so there is no Slate hit-test walk and no Blueprint conversion every frame. Hover and press events are raised only when hovered element changes.
+ * Owner actor still implements IControllerPointable; controller updates this component itself when its pointing trace hits it
+ */
+UCLASS(ClassGroup = VR, meta = (BlueprintSpawnableComponent))
+class PROJECTVRBASICS_API UVRPointableWidgetComponent : public UWidgetComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Called by motion controller
+	void UpdatePointer(AVirtualRealityMotionController* MotionController, const FVector& WorldHitLocation);
+	void EndPointer(AVirtualRealityMotionController* MotionController);
+
+	// Pressing and releasing over the same element clicks it if it is a button (see bClickButtons). Usually called from owner`s IVRPlayerInput events
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Widget")
+	void PressPointer(AVirtualRealityMotionController* MotionController);
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Widget")
+	void ReleasePointer(AVirtualRealityMotionController* MotionController);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VR Pointable Widget")
+	UWidget* GetHoveredElement(AVirtualRealityMotionController* MotionController) const;
+
+	// Elements are cached every HitGridRefreshInterval while pointed at. Call it when layout changed (f.e. list was filled or scrolled) so it is cached right away
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Widget")
+	void InvalidateHitGrid() { bHitGridDirty = true; }
+
+	// Widget is redrawn on next frame even if nobody points at it (see bBudgetRedraw)
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Widget")
+	void MarkContentChanged() { bContentChanged = true; }
+
+	UPROPERTY(BlueprintAssignable, Category = "VR Pointable Widget")
+	FVRPointedWidgetElementEvent OnElementHovered;
+	UPROPERTY(BlueprintAssignable, Category = "VR Pointable Widget")
+	FVRPointedWidgetElementEvent OnElementUnhovered;
+	UPROPERTY(BlueprintAssignable, Category = "VR Pointable Widget")
+	FVRPointedWidgetElementEvent OnElementPressed;
+	UPROPERTY(BlueprintAssignable, Category = "VR Pointable Widget")
+	FVRPointedWidgetElementEvent OnElementReleased;
+
+protected:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Pointable Widget", meta = (ClampMin = "0", Units = "s"))
+	float HitGridRefreshInterval = 0.25f;
+	// Cells per side of the grid
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Pointable Widget", meta = (ClampMin = "1", ClampMax = "64"))
+	int32 HitGridResolution = 16;
+	// Broadcast UButton::OnClicked when button is pressed and released while pointed at
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Pointable Widget")
+	bool bClickButtons = true;
+
+	// Widget is redrawn every frame only while pointed at, otherwise at UnpointedRedrawRate or after MarkContentChanged(), within per frame budget of UVRWidgetRedrawBudget
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Pointable Widget")
+	bool bBudgetRedraw = true;
+	// 0 keeps widget frozen until its content changes
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Pointable Widget", meta = (EditCondition = "bBudgetRedraw", ClampMin = "0", Units = "Hz"))
+	float UnpointedRedrawRate = 0.f;
+
+private:
+	struct FHitElement
+	{
+		TWeakObjectPtr<UWidget> Widget;
+		FBox2D Box;
+	};
+
+	struct FPointerState
+	{
+		TWeakObjectPtr<AVirtualRealityMotionController> MotionController;
+		TWeakObjectPtr<UWidget> HoveredElement;
+		TWeakObjectPtr<UWidget> PressedElement;
+	};
+
+	void RebuildHitGrid();
+	UWidget* FindElementAt(const FVector2D& WidgetLocation) const;
+	FPointerState* FindPointer(const AVirtualRealityMotionController* MotionController);
+	const FPointerState* FindPointer(const AVirtualRealityMotionController* MotionController) const;
+
+	TArray<FHitElement> HitElements; // In paint order, later ones are on top
+	TArray<TArray<int32, TInlineAllocator<4>>> HitGridCells;
+	FVector2D HitGridSize = FVector2D::ZeroVector;
+	double HitGridBuildTime = 0.0;
+	bool bHitGridDirty = true;
+
+	TArray<FPointerState, TInlineAllocator<2>> Pointers;
+
+	void RequestBudgetedRedraw();
+
+	double LastRedrawTime = 0.0;
+	bool bContentChanged = true; // First frame is always drawn
+};
@@ -0,0 +1,35 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRPointingProxyComponent.h"
+
+
+UVRPointingProxyComponent::UVRPointingProxyComponent()
+{
+	SetCollisionProfileName(TEXT("VRPointingProxy"));
+	SetGenerateOverlapEvents(false);
+	SetCanEverAffectNavigation(false);
+	SetHiddenInGame(true);
+	CanCharacterStepUpOn = ECB_No;
+}
+
+void UVRPointingProxyComponent::SetSourceComponent(UPrimitiveComponent* Source)
+{
+	SourceComponent = Source;
+	if (!Source) return;
+
+	// Inheriting scale, so extent is in local space of the source
+	AttachToComponent(Source, FAttachmentTransformRules::SnapToTargetIncludingScale);
+
+	const FBoxSphereBounds LocalBounds = Source->CalcBounds(FTransform::Identity);
+	SetRelativeLocation(LocalBounds.Origin);
+	SetBoxExtent(LocalBounds.BoxExtent, false);
+}
+
+USceneComponent* UVRPointingProxyComponent::ResolveHitComponent(USceneComponent* HitComponent)
+{
+	UVRPointingProxyComponent* Proxy = Cast<UVRPointingProxyComponent>(HitComponent);
+	if (Proxy && Proxy->GetSourceComponent()) return Proxy->GetSourceComponent();
+
+	return HitComponent;
+}
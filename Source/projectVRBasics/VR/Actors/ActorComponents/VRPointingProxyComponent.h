@@ -0,0 +1,34 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/BoxComponent.h"
+#include "VRPointingProxyComponent.generated.h"
+
+// Trace channel that is blocked only by pointing proxies and opted-in occluders (see DefaultEngine.ini)
+#define ECC_VRPointing ECC_GameTraceChannel1
+
+/**
+ * Simple box that is hit by pointing traces instead of full collision of its source component (see AVirtualRealityMotionController::bPointAtProxiesOnly).
+ * Created by UVRPointableRegistry for every IControllerPointable actor that has no proxies of its own, or added by hand to take control over pointable shape.
+ * Any other component that should stop pointing ray (walls, doors) opts in by blocking VRPointing channel
+ */
+UCLASS(ClassGroup = VR, meta = (BlueprintSpawnableComponent))
+class PROJECTVRBASICS_API UVRPointingProxyComponent : public UBoxComponent
+{
+	GENERATED_BODY()
+
+public:
+	UVRPointingProxyComponent();
+
+	// Attaches to Source and fits its local bounds
+	void SetSourceComponent(UPrimitiveComponent* Source);
+	UPrimitiveComponent* GetSourceComponent() const { return SourceComponent.Get(); }
+
+	// Component that is reported to IControllerPointable for a hit: source of a generated proxy, otherwise hit component itself
+	static USceneComponent* ResolveHitComponent(USceneComponent* HitComponent);
+
+private:
+	TWeakObjectPtr<UPrimitiveComponent> SourceComponent;
+};
@@ -6,6 +6,8 @@
 #include "UObject/Interface.h"
 #include "ControllerPointable.generated.h"
 
+class AVirtualRealityMotionController;
+
 // This class does not need to be modified.
 UINTERFACE(MinimalAPI, Blueprintable)
 class UControllerPointable : public UInterface
@@ -25,4 +27,14 @@ public:
 	void OnGetPointed(AVirtualRealityMotionController* MotionController, USceneComponent* CollidedComponent, FVector HitLocation);
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "IControllerPointable")
 	void OnEndPointed(AVirtualRealityMotionController* MotionController);
+
+	// Max rate of repeated OnGetPointed while this actor stays pointed at (see AVirtualRealityMotionController::bThrottlePointedHover). Asked once when pointing begins, 0 uses controller`s PointedHoverMaxRate
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "IControllerPointable")
+	float GetPointedHoverMaxRate() const;
+	float GetPointedHoverMaxRate_Implementation() const { return 0.f; };
+
+	// Native counterparts of hot events for C++ implementers, called by FVRInterfaceDispatch before Blueprint event. Return true if event was handled so Blueprint event is skipped
+	virtual bool NativeOnGetPointed(AVirtualRealityMotionController* MotionController, USceneComponent* CollidedComponent, const FVector& HitLocation) { return false; }
+	virtual bool NativeOnEndPointed(AVirtualRealityMotionController* MotionController) { return false; }
+	virtual bool NativeGetPointedHoverMaxRate(float& OutMaxRate) const { return false; }
 };
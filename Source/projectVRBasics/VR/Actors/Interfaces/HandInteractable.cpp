@@ -0,0 +1,11 @@
+// Alex Smirnov 2020-2021
+
+
+#include "HandInteractable.h"
+
+bool IHandInteractable::UsesCustomGrabDistance_Implementation() const
+{
+	// Blueprints made before this event existed override only GetWorldSquaredDistanceToMotionController, so they keep being asked until they override this event too
+	const UObject* Object = _getUObject();
+	return Object && Object->GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(IHandInteractable, GetWorldSquaredDistanceToMotionController));
+}
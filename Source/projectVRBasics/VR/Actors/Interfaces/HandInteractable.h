@@ -6,6 +6,8 @@
 #include "UObject/Interface.h"
 #include "HandInteractable.generated.h"
 
+class AVRMotionControllerHand;
+
 UINTERFACE(MinimalAPI, Blueprintable)
 class UHandInteractable : public UInterface
 {
@@ -58,10 +60,16 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "IHandInteractable")
 	void OnHandTick(AVRMotionControllerHand* HandMotionController);
 
-	// When player tries to grab but overlaps multiple IHandInteractable actors, the one with the lowest distance will be chosen
+	// When player tries to grab but overlaps multiple IHandInteractable actors, the one with the lowest distance will be chosen.
+	// Called only if UsesCustomGrabDistance() returns true, otherwise distance from UVRGrabPointComponent (or actor location) to the hand is measured natively
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "IHandInteractable")
 	float GetWorldSquaredDistanceToMotionController(const AVRMotionControllerHand* HandMotionController) const;
 	float GetWorldSquaredDistanceToMotionController_Implementation(const AVRMotionControllerHand* HandMotionController) const { return 0.f; };
+	// Return true if GetWorldSquaredDistanceToMotionController() is overridden in Blueprint. Asked once when actor becomes grab candidate of a hand.
+	// By default true if Blueprint has a GetWorldSquaredDistanceToMotionController graph. Editor creates that graph when interface is added, so Blueprints that do not measure distance themselves should override this to return false
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "IHandInteractable")
+	bool UsesCustomGrabDistance() const;
+	bool UsesCustomGrabDistance_Implementation() const;
 
 	// Default False - Object is held only when we press button and drops on release. True - First button press will grab and second will drop
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "IHandInteractable")
@@ -76,4 +84,12 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "IHandInteractable")
 	bool IsDropDisabled() const;
 	bool IsDropDisabled_Implementation() const { return false; };
+
+	// Native counterparts of hot events for C++ implementers, called by FVRInterfaceDispatch before Blueprint events. Return true if event was handled so Blueprint event is skipped
+	virtual bool NativeOnHandTick(AVRMotionControllerHand* HandMotionController) { return false; }
+	virtual bool NativeOnCanBeGrabbedByHand_Start(AVRMotionControllerHand* HandMotionController, USceneComponent* CollidedComponent) { return false; }
+	virtual bool NativeOnCanBeGrabbedByHand_End(AVRMotionControllerHand* HandMotionController, USceneComponent* CollidedComponent) { return false; }
+	// Returning false here means distance is measured natively (or asked from Blueprint if UsesCustomGrabDistance() is true)
+	virtual bool NativeGetWorldSquaredDistanceToMotionController(const AVRMotionControllerHand* HandMotionController, float& OutSquaredDistance) const { return false; }
+	virtual bool NativeIsGrabDisabled(bool& bOutGrabDisabled) const { return false; }
 };
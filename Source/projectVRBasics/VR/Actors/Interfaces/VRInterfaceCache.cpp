@@ -0,0 +1,85 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInterfaceCache.h"
+
+#include "UObject/UObjectGlobals.h"
+
+#include "ControllerPointable.h"
+#include "HandInteractable.h"
+#include "VRPlayerInput.h"
+
+
+namespace VRInterfaceCache
+{
+	static void RegisterInvalidation()
+	{
+		static bool bRegistered = false;
+		if (bRegistered) return;
+		bRegistered = true;
+
+		FCoreUObjectDelegates::GetPostGarbageCollect().AddStatic(&FVRInterfaceCache::Invalidate);
+#if WITH_EDITOR
+		// Recompiled Blueprint classes are reinstanced and may add or remove interfaces
+		FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const TMap<UObject*, UObject*>&) { FVRInterfaceCache::Invalidate(); });
+#endif
+	}
+}
+
+bool FVRInterfaceCache::Implements(const UObject* Object, EVRInterface Interface)
+{
+	return Object && EnumHasAnyFlags(Get(Object->GetClass()).Implemented, Interface);
+}
+
+bool FVRInterfaceCache::ImplementsNatively(const UObject* Object, EVRInterface Interface)
+{
+	return Object && EnumHasAnyFlags(Get(Object->GetClass()).Native, Interface);
+}
+
+void FVRInterfaceCache::Invalidate()
+{
+	GetClasses().Reset();
+}
+
+const FVRInterfaceCache::FClassInterfaces& FVRInterfaceCache::Get(const UClass* Class)
+{
+	TMap<const UClass*, FClassInterfaces>& Classes = GetClasses();
+
+	if (const FClassInterfaces* ClassInterfaces = Classes.Find(Class)) return *ClassInterfaces;
+
+	VRInterfaceCache::RegisterInvalidation();
+	return Classes.Add(Class, Build(Class));
+}
+
+TMap<const UClass*, FVRInterfaceCache::FClassInterfaces>& FVRInterfaceCache::GetClasses()
+{
+	static TMap<const UClass*, FClassInterfaces> Classes;
+	return Classes;
+}
+
+FVRInterfaceCache::FClassInterfaces FVRInterfaceCache::Build(const UClass* Class)
+{
+	const TPair<UClass*, EVRInterface> Interfaces[] = {
+		{ UControllerPointable::StaticClass(), EVRInterface::ControllerPointable },
+		{ UVRPlayerInput::StaticClass(), EVRInterface::PlayerInput },
+		{ UHandInteractable::StaticClass(), EVRInterface::HandInteractable }
+	};
+
+	FClassInterfaces ClassInterfaces;
+
+	for (const UClass* CurrentClass = Class; CurrentClass; CurrentClass = CurrentClass->GetSuperClass())
+	{
+		for (const FImplementedInterface& ImplementedInterface : CurrentClass->Interfaces)
+		{
+			for (const TPair<UClass*, EVRInterface>& Interface : Interfaces)
+			{
+				if (!ImplementedInterface.Class || !ImplementedInterface.Class->IsChildOf(Interface.Key)) continue;
+
+				ClassInterfaces.Implemented |= Interface.Value;
+				if (!ImplementedInterface.bImplementedByK2) ClassInterfaces.Native |= Interface.Value; // Added in C++ class
+			}
+		}
+	}
+
+	return ClassInterfaces;
+}
@@ -0,0 +1,39 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// VR interfaces that are checked on hot paths
+enum class EVRInterface : uint8 {
+	None = 0,
+	ControllerPointable = 1 << 0,
+	PlayerInput = 1 << 1,
+	HandInteractable = 1 << 2
+};
+ENUM_CLASS_FLAGS(EVRInterface)
+
+/**
+ * Interfaces that a class implements, stored per UClass as a bitmask. Filled on first check of a class, so every next check is one hashed lookup and a bit test instead of a walk over class interfaces.
+ * Cache is cleared after garbage collection (classes may be unloaded) and when Blueprints are recompiled. Game thread only
+ */
+struct PROJECTVRBASICS_API FVRInterfaceCache
+{
+	// Same as UObject::Implements<>(), true for interfaces added in C++ and in Blueprints
+	static bool Implements(const UObject* Object, EVRInterface Interface);
+	// Interface is implemented in C++, so Cast<> to it returns valid pointer
+	static bool ImplementsNatively(const UObject* Object, EVRInterface Interface);
+
+	static void Invalidate();
+
+private:
+	struct FClassInterfaces
+	{
+		EVRInterface Implemented = EVRInterface::None;
+		EVRInterface Native = EVRInterface::None;
+	};
+
+	static const FClassInterfaces& Get(const UClass* Class);
+	static FClassInterfaces Build(const UClass* Class);
+	static TMap<const UClass*, FClassInterfaces>& GetClasses();
+};
@@ -0,0 +1,153 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInterfaceDispatch.h"
+
+#include "ControllerPointable.h"
+#include "HandInteractable.h"
+#include "VRInterfaceCache.h"
+
+
+// Blueprint-only implementers skip the Cast, which would walk class interfaces just to return nullptr
+template<typename TInterface>
+static TInterface* CastNative(UObject* Target, EVRInterface Interface)
+{
+	return FVRInterfaceCache::ImplementsNatively(Target, Interface) ? Cast<TInterface>(Target) : nullptr;
+}
+
+
+// IControllerPointable
+
+void FVRInterfaceDispatch::OnGetPointed(UObject* Target, AVirtualRealityMotionController* MotionController, USceneComponent* CollidedComponent, const FVector& HitLocation)
+{
+	IControllerPointable* NativeInterface = CastNative<IControllerPointable>(Target, EVRInterface::ControllerPointable);
+	if (NativeInterface && NativeInterface->NativeOnGetPointed(MotionController, CollidedComponent, HitLocation)) return;
+
+	IControllerPointable::Execute_OnGetPointed(Target, MotionController, CollidedComponent, HitLocation);
+}
+
+void FVRInterfaceDispatch::OnEndPointed(UObject* Target, AVirtualRealityMotionController* MotionController)
+{
+	IControllerPointable* NativeInterface = CastNative<IControllerPointable>(Target, EVRInterface::ControllerPointable);
+	if (NativeInterface && NativeInterface->NativeOnEndPointed(MotionController)) return;
+
+	IControllerPointable::Execute_OnEndPointed(Target, MotionController);
+}
+
+float FVRInterfaceDispatch::GetPointedHoverMaxRate(UObject* Target)
+{
+	float MaxRate = 0.f;
+
+	IControllerPointable* NativeInterface = CastNative<IControllerPointable>(Target, EVRInterface::ControllerPointable);
+	if (NativeInterface && NativeInterface->NativeGetPointedHoverMaxRate(MaxRate)) return MaxRate;
+
+	return IControllerPointable::Execute_GetPointedHoverMaxRate(Target);
+}
+
+// IHandInteractable
+
+void FVRInterfaceDispatch::OnHandTick(UObject* Target, AVRMotionControllerHand* HandMotionController)
+{
+	IHandInteractable* NativeInterface = CastNative<IHandInteractable>(Target, EVRInterface::HandInteractable);
+	if (NativeInterface && NativeInterface->NativeOnHandTick(HandMotionController)) return;
+
+	IHandInteractable::Execute_OnHandTick(Target, HandMotionController);
+}
+
+void FVRInterfaceDispatch::OnCanBeGrabbedByHand_Start(UObject* Target, AVRMotionControllerHand* HandMotionController, USceneComponent* CollidedComponent)
+{
+	IHandInteractable* NativeInterface = CastNative<IHandInteractable>(Target, EVRInterface::HandInteractable);
+	if (NativeInterface && NativeInterface->NativeOnCanBeGrabbedByHand_Start(HandMotionController, CollidedComponent)) return;
+
+	IHandInteractable::Execute_OnCanBeGrabbedByHand_Start(Target, HandMotionController, CollidedComponent);
+}
+
+void FVRInterfaceDispatch::OnCanBeGrabbedByHand_End(UObject* Target, AVRMotionControllerHand* HandMotionController, USceneComponent* CollidedComponent)
+{
+	IHandInteractable* NativeInterface = CastNative<IHandInteractable>(Target, EVRInterface::HandInteractable);
+	if (NativeInterface && NativeInterface->NativeOnCanBeGrabbedByHand_End(HandMotionController, CollidedComponent)) return;
+
+	IHandInteractable::Execute_OnCanBeGrabbedByHand_End(Target, HandMotionController, CollidedComponent);
+}
+
+float FVRInterfaceDispatch::GetWorldSquaredDistanceToMotionController(UObject* Target, const AVRMotionControllerHand* HandMotionController)
+{
+	float SquaredDistance = 0.f;
+
+	IHandInteractable* NativeInterface = CastNative<IHandInteractable>(Target, EVRInterface::HandInteractable);
+	if (NativeInterface && NativeInterface->NativeGetWorldSquaredDistanceToMotionController(HandMotionController, SquaredDistance)) return SquaredDistance;
+
+	return IHandInteractable::Execute_GetWorldSquaredDistanceToMotionController(Target, HandMotionController);
+}
+
+bool FVRInterfaceDispatch::IsGrabDisabled(UObject* Target)
+{
+	bool bGrabDisabled = false;
+
+	IHandInteractable* NativeInterface = CastNative<IHandInteractable>(Target, EVRInterface::HandInteractable);
+	if (NativeInterface && NativeInterface->NativeIsGrabDisabled(bGrabDisabled)) return bGrabDisabled;
+
+	return IHandInteractable::Execute_IsGrabDisabled(Target);
+}
+
+// IVRPlayerInput
+
+void FVRInterfaceDispatch::Input_Axis_Thumbstick(UObject* Target, float Horizontal, float Vertical)
+{
+	IVRPlayerInput* NativeInterface = CastNative<IVRPlayerInput>(Target, EVRInterface::PlayerInput);
+	if (NativeInterface && NativeInterface->NativeInput_Axis_Thumbstick(Horizontal, Vertical)) return;
+
+	IVRPlayerInput::Execute_Input_Axis_Thumbstick(Target, Horizontal, Vertical);
+}
+
+void FVRInterfaceDispatch::Input_Axis_Trigger(UObject* Target, float Value)
+{
+	IVRPlayerInput* NativeInterface = CastNative<IVRPlayerInput>(Target, EVRInterface::PlayerInput);
+	if (NativeInterface && NativeInterface->NativeInput_Axis_Trigger(Value)) return;
+
+	IVRPlayerInput::Execute_Input_Axis_Trigger(Target, Value);
+}
+
+void FVRInterfaceDispatch::Input_Axis_Grip(UObject* Target, float Value)
+{
+	IVRPlayerInput* NativeInterface = CastNative<IVRPlayerInput>(Target, EVRInterface::PlayerInput);
+	if (NativeInterface && NativeInterface->NativeInput_Axis_Grip(Value)) return;
+
+	IVRPlayerInput::Execute_Input_Axis_Grip(Target, Value);
+}
+
+void FVRInterfaceDispatch::Input_Button(UObject* Target, EVRInputButton Button, EButtonActionType ActionType)
+{
+	IVRPlayerInput* NativeInterface = CastNative<IVRPlayerInput>(Target, EVRInterface::PlayerInput);
+	if (NativeInterface && NativeInterface->NativeInput_Button(Button, ActionType)) return;
+
+	switch (Button)
+	{
+	case EVRInputButton::Primary: IVRPlayerInput::Execute_Input_Button_Primary(Target, ActionType); break;
+	case EVRInputButton::Secondary: IVRPlayerInput::Execute_Input_Button_Secondary(Target, ActionType); break;
+	case EVRInputButton::Thumbstick: IVRPlayerInput::Execute_Input_Button_Thumbstick(Target, ActionType); break;
+	case EVRInputButton::Trigger: IVRPlayerInput::Execute_Input_Button_Trigger(Target, ActionType); break;
+	case EVRInputButton::Grip: IVRPlayerInput::Execute_Input_Button_Grip(Target, ActionType); break;
+	case EVRInputButton::Menu: IVRPlayerInput::Execute_Input_Button_Menu(Target, ActionType); break;
+	case EVRInputButton::System: IVRPlayerInput::Execute_Input_Button_System(Target, ActionType); break;
+	default: break;
+	}
+}
+
+void FVRInterfaceDispatch::Input_Frame(UObject* Target, const FVRInputFrame& Frame)
+{
+	IVRPlayerInput* NativeInterface = CastNative<IVRPlayerInput>(Target, EVRInterface::PlayerInput);
+	if (NativeInterface && NativeInterface->NativeInput_Frame(Frame)) return;
+
+	IVRPlayerInput::Execute_Input_Frame(Target, Frame);
+}
+
+FConsumeInputParams FVRInterfaceDispatch::GetConsumeInputParams(UObject* Target)
+{
+	FConsumeInputParams ConsumeInputParams;
+
+	IVRPlayerInput* NativeInterface = CastNative<IVRPlayerInput>(Target, EVRInterface::PlayerInput);
+	if (NativeInterface && NativeInterface->NativeGetConsumeInputParams(ConsumeInputParams)) return ConsumeInputParams;
+
+	return IVRPlayerInput::Execute_GetConsumeInputParams(Target);
+}
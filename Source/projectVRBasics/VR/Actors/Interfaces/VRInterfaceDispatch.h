@@ -0,0 +1,39 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRPlayerInput.h"
+
+class AVirtualRealityMotionController;
+class AVRMotionControllerHand;
+class USceneComponent;
+
+/**
+ * Calls interface events on hot paths (every frame or every input event).
+ * If target class implements interface in C++, native counterpart (Native* virtuals of the interface) is called first and Blueprint event is called only if native one did not handle it.
+ * Actors that implement interfaces only in Blueprints go straight to Execute_* as before
+ */
+struct PROJECTVRBASICS_API FVRInterfaceDispatch
+{
+	// IControllerPointable
+	static void OnGetPointed(UObject* Target, AVirtualRealityMotionController* MotionController, USceneComponent* CollidedComponent, const FVector& HitLocation);
+	static void OnEndPointed(UObject* Target, AVirtualRealityMotionController* MotionController);
+	static float GetPointedHoverMaxRate(UObject* Target);
+
+	// IHandInteractable
+	static void OnHandTick(UObject* Target, AVRMotionControllerHand* HandMotionController);
+	static void OnCanBeGrabbedByHand_Start(UObject* Target, AVRMotionControllerHand* HandMotionController, USceneComponent* CollidedComponent);
+	static void OnCanBeGrabbedByHand_End(UObject* Target, AVRMotionControllerHand* HandMotionController, USceneComponent* CollidedComponent);
+	static float GetWorldSquaredDistanceToMotionController(UObject* Target, const AVRMotionControllerHand* HandMotionController);
+	static bool IsGrabDisabled(UObject* Target);
+
+	// IVRPlayerInput
+	static void Input_Axis_Thumbstick(UObject* Target, float Horizontal, float Vertical);
+	static void Input_Axis_Trigger(UObject* Target, float Value);
+	static void Input_Axis_Grip(UObject* Target, float Value);
+	static void Input_Button(UObject* Target, EVRInputButton Button, EButtonActionType ActionType);
+	static void Input_Frame(UObject* Target, const FVRInputFrame& Frame);
+	static FConsumeInputParams GetConsumeInputParams(UObject* Target);
+};
@@ -4,15 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Interface.h"
-#include "VRPlayerInput.generated.h"
 
-UENUM(BlueprintType)
-enum class EButtonActionType : uint8 {
-	Touched = 0 UMETA(DisplayName = "Touched"),
-	Pressed = 1 UMETA(DisplayName = "Pressed"),
-	ReleasedPress = 2 UMETA(DisplayName = "Released Press"),
-	ReleasedTouch = 3 UMETA(DisplayName = "Released Touch")
-};
+#include "../../Input/VRInputTypes.h"
+#include "../../Input/VRInputFrame.h"
+
+#include "VRPlayerInput.generated.h"
 
 USTRUCT(BlueprintType)
 struct FConsumeInputParams_Axes
@@ -75,6 +71,21 @@ struct FConsumeInputParams
 	FConsumeInputParams_Axes Axes;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FConsumeInputParams_Buttons Buttons;
+
+	// Same params as a mask of VRInput::AxisBit() and VRInput::ButtonBit()
+	uint32 GetControlsMask() const
+	{
+		uint32 Mask = 0;
+		if (Axes.Thumbstick) Mask |= VRInput::AxisBit(EVRInputAxis::Thumbstick_X) | VRInput::AxisBit(EVRInputAxis::Thumbstick_Y);
+		if (Axes.Trigger) Mask |= VRInput::AxisBit(EVRInputAxis::Trigger);
+		if (Axes.Grip) Mask |= VRInput::AxisBit(EVRInputAxis::Grip);
+		if (Buttons.Primary) Mask |= VRInput::ButtonBit(EVRInputButton::Primary);
+		if (Buttons.Secondary) Mask |= VRInput::ButtonBit(EVRInputButton::Secondary);
+		if (Buttons.Thumbstick) Mask |= VRInput::ButtonBit(EVRInputButton::Thumbstick);
+		if (Buttons.Trigger) Mask |= VRInput::ButtonBit(EVRInputButton::Trigger);
+		if (Buttons.Grip) Mask |= VRInput::ButtonBit(EVRInputButton::Grip);
+		return Mask;
+	}
 };
 
 UINTERFACE(MinimalAPI, Blueprintable)
@@ -113,7 +124,19 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "IVRPlayerInput")
 	void Input_Button_System(EButtonActionType ActionType);
 
+	// Everything that happened to one hand`s controls since previous frame. Called once per Tick and only if something changed
+	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "IVRPlayerInput")
+	void Input_Frame(const FVRInputFrame& Frame);
+
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "IVRPlayerInput")
 	FConsumeInputParams GetConsumeInputParams() const;
 	FConsumeInputParams GetConsumeInputParams_Implementation() const { return FConsumeInputParams(); };
+
+	// Native counterparts of events above for C++ implementers, called by FVRInterfaceDispatch before Blueprint events. Return true if event was handled so Blueprint event is skipped
+	virtual bool NativeInput_Axis_Thumbstick(float Horizontal, float Vertical) { return false; }
+	virtual bool NativeInput_Axis_Trigger(float Value) { return false; }
+	virtual bool NativeInput_Axis_Grip(float Value) { return false; }
+	virtual bool NativeInput_Button(EVRInputButton Button, EButtonActionType ActionType) { return false; }
+	virtual bool NativeInput_Frame(const FVRInputFrame& Frame) { return false; }
+	virtual bool NativeGetConsumeInputParams(FConsumeInputParams& OutConsumeInputParams) const { return false; }
 };
@@ -11,10 +11,13 @@
 #include "HandActor.h"
 #include "VirtualRealityPawn.h"
 #include "HandPhysConstraint.h"
-#include "Math/NumericLimits.h"
 
 #include "Interfaces/VRPlayerInput.h"
 #include "Interfaces/HandInteractable.h"
+#include "Interfaces/VRInterfaceDispatch.h"
+#include "Interfaces/VRInterfaceCache.h"
+
+#include "../Subsystems/VRInteractableGrid.h"
 
 
 AVRMotionControllerHand::AVRMotionControllerHand()
@@ -46,6 +49,7 @@ void AVRMotionControllerHand::Destroyed()
 	Super::Destroyed();
 
 	TryToReleaseGrabbedActor();
+	if (KinematicAttachmentComponent) KinematicAttachmentComponent->SetSimulatePhysics(true); // Hand is gone before actor reached it
 
 	if (HandActor)
 	{
@@ -64,12 +68,15 @@ void AVRMotionControllerHand::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 
 	if (bIsAttachmentIsInTransitionToHand) UpdateAttachedActorLocation(DeltaTime); // If we grabbed something, updating its location here until it reaches its destination
-	else if (ConnectedActorWithHandInteractableInterface) IHandInteractable::Execute_OnHandTick(ConnectedActorWithHandInteractableInterface, this);
+	else if (ConnectedActorWithHandInteractableInterface) FVRInterfaceDispatch::OnHandTick(ConnectedActorWithHandInteractableInterface, this);
+
+	if (InteractableGrid) UpdateGridGrabCandidates();
+	UpdateBestGrabCandidate();
 }
 
 void AVRMotionControllerHand::OnBeginPlayWaitEnd()
 {
-	if (!MotionController->IsTracked() || MotionController->CurrentTrackingStatus != ETrackingStatus::Tracked)
+	if (!IsTrackingReplayed() && (!MotionController->IsTracked() || MotionController->CurrentTrackingStatus != ETrackingStatus::Tracked))
 	{
 		// Timer will loop for now
 		UE_LOG(LogTemp, Warning, TEXT("AVRMotionControllerHand Init was skipped for now. Will retry"));
@@ -82,7 +89,14 @@ void AVRMotionControllerHand::OnBeginPlayWaitEnd()
 	HandActor->SetOwner(this);
 	HandActor->SetInstigator(OwningVRPawn);
 
-	HandActor->SetupHandSphereCollisionCallbacks(this);
+	GrabSphereComponent = HandActor->GetCollisionSphereComponent();
+	InteractableGrid = bUseInteractableGrid && GrabSphereComponent ? GetWorld()->GetSubsystem<UVRInteractableGrid>() : nullptr;
+	if (InteractableGrid)
+	{
+		InteractableGrid->Activate(GrabSphereComponent); // Before sphere collision is disabled, grid filters components by its responses
+		GrabSphereComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision); // Sphere is only used for its bounds, physics does not need to track its overlaps
+	}
+	else HandActor->SetupHandSphereCollisionCallbacks(this);
 
 	HandActor->ChangeHandPhysProperties(false, true); // Attaching constraint without simulated physics will result in a warning, so setting hand`s SimulatePhysycs:true
 	StartFollowingPhantomHand(false);
@@ -220,33 +234,62 @@ AHandPhysConstraint* AVRMotionControllerHand::GetPhysConstraint()
 
 void AVRMotionControllerHand::HandCollisionSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
-	if (!OtherActor->Implements<UHandInteractable>()) return; // If we just cast OtherActor to IHandInteractable, Implements() will return true and Cast<IHandInteractable>(OtherActor) will return nullptr because we added interface in BP and not in cpp class
-	// This and EndOverlap gets triggered a lot more than needed. Consider using custom collision presets with custom object types to reduce unnecessary calls
-	OverlappingActorsArray.Add(OtherActor);
-	IHandInteractable::Execute_OnCanBeGrabbedByHand_Start(OtherActor, this, OtherComp);
+	if (!FVRInterfaceCache::Implements(OtherActor, EVRInterface::HandInteractable)) return; // If we just cast OtherActor to IHandInteractable, Implements() will return true and Cast<IHandInteractable>(OtherActor) will return nullptr because we added interface in BP and not in cpp class
+	// This and EndOverlap gets triggered for every overlapping component, so actor is notified only when its first component starts overlapping
+	AddGrabCandidate(OtherActor, OtherComp);
 
 	//UE_LOG(LogTemp, Warning, TEXT("BeginOverlap --- OtherActor:%s --- OtherComp:%s"), *OtherActor->GetName(), *OtherComp->GetName());
 }
 
 void AVRMotionControllerHand::HandCollisionSphereEndOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
-	if (!OtherActor->Implements<UHandInteractable>()) return;
+	if (!FVRInterfaceCache::Implements(OtherActor, EVRInterface::HandInteractable)) return;
 	
-	OverlappingActorsArray.Remove(OtherActor);
-	IHandInteractable::Execute_OnCanBeGrabbedByHand_End(OtherActor, this, OtherComp);
+	RemoveGrabCandidate(OtherActor, OtherComp);
 
 	//UE_LOG(LogTemp, Warning, TEXT("EndOverlap --- OtherActor:%s --- OtherComp:%s"), *OtherActor->GetName(), *OtherComp->GetName());
 }
 
-AActor* AVRMotionControllerHand::GetActorToForwardInputTo()
+void AVRMotionControllerHand::AddGrabCandidate(AActor* Actor, UPrimitiveComponent* CollidedComponent)
+{
+	if (!GrabCandidates.AddReference(Actor)) return; // Not the first overlapping component
+
+	bBestGrabCandidateDirty = true;
+	FVRInterfaceDispatch::OnCanBeGrabbedByHand_Start(Actor, this, CollidedComponent);
+}
+
+void AVRMotionControllerHand::RemoveGrabCandidate(AActor* Actor, UPrimitiveComponent* CollidedComponent)
+{
+	if (!GrabCandidates.RemoveReference(Actor)) return; // Not the last overlapping component
+
+	bBestGrabCandidateDirty = true;
+	FVRInterfaceDispatch::OnCanBeGrabbedByHand_End(Actor, this, CollidedComponent);
+}
+
+void AVRMotionControllerHand::UpdateGridGrabCandidates()
 {
-	AActor* ActorToForwardInputTo = Super::GetActorToForwardInputTo();
-	if (ActorToForwardInputTo == nullptr && bGrabbedObjectImplementsPlayerInputInterface && !bIsAttachmentIsInTransitionToHand)
+	if (GrabSphereComponent && GrabSphereComponent->GetGenerateOverlapEvents())
+	{
+		InteractableGrid->QuerySphere(GrabSphereComponent->Bounds.Origin, GrabSphereComponent->Bounds.SphereRadius, GridQueryActors);
+	}
+	else GridQueryActors.Reset();
+
+	// Both lists hold only actors around the hand, so linear search is fine. Collided component is unknown without overlaps
+	GrabCandidates.GetActors(GridPreviousActors);
+	for (AActor* Actor : GridPreviousActors)
 	{
-		return ConnectedActorWithHandInteractableInterface;
+		if (!GridQueryActors.Contains(Actor)) RemoveGrabCandidate(Actor, nullptr);
 	}
+	for (AActor* Actor : GridQueryActors)
+	{
+		if (GrabCandidates.Find(Actor) == INDEX_NONE) AddGrabCandidate(Actor, nullptr);
+	}
+}
 
-	return ActorToForwardInputTo;
+UObject* AVRMotionControllerHand::GetHeldInputReceiver() const
+{
+	if (bGrabbedObjectImplementsPlayerInputInterface && !bIsAttachmentIsInTransitionToHand) return ConnectedActorWithHandInteractableInterface;
+	return nullptr;
 }
 
 bool AVRMotionControllerHand::CanDoPointingChecks() const
@@ -262,23 +305,45 @@ bool AVRMotionControllerHand::CanDoPointingChecks() const
 
 int32 AVRMotionControllerHand::GetClosestGrabbableActorIndex() const
 {
-	if (OverlappingActorsArray.Num() == 0) return -1;
+	// Blueprint GetWorldSquaredDistanceToMotionController() is called only for actors that opt in with UsesCustomGrabDistance(), C++ implementers are asked through native virtuals
+	return GrabCandidates.FindClosest(this, GetPhantomHandWorldTransform().GetLocation(), true);
+}
 
-	int32 IndexToReturn = -1;
-	TNumericLimits<float> TNumericLimitsFloat = TNumericLimits<float>();
-	float CurrentDistance = TNumericLimitsFloat.Max();
+void AVRMotionControllerHand::UpdateBestGrabCandidate()
+{
+	bBestGrabCandidateDirty = false;
 
-	for (int32 i = 0; i < OverlappingActorsArray.Num(); ++i)
+	AActor* NewCandidate = nullptr;
+	if (!bIsGrabbing && !ConnectedActorWithHandInteractableInterface && GrabCandidates.Num() > 0)
 	{
-		float Distance = IHandInteractable::Execute_GetWorldSquaredDistanceToMotionController(OverlappingActorsArray[i], this);
-		if (Distance < CurrentDistance && !IHandInteractable::Execute_IsGrabDisabled(OverlappingActorsArray[i]))
-		{
-			IndexToReturn = i;
-			CurrentDistance = Distance;
-		}
+		// Lanes of actors that did not move are reused and no Blueprint events are called, so this is one vectorized pass over candidates (see FVRGrabCandidateTable)
+		const int32 CandidateIndex = GrabCandidates.FindClosest(this, GetPhantomHandWorldTransform().GetLocation(), false);
+		if (CandidateIndex != INDEX_NONE) NewCandidate = GrabCandidates.GetActor(CandidateIndex);
 	}
 
-	return IndexToReturn;
+	if (NewCandidate == BestGrabCandidate) return;
+
+	AActor* PreviousCandidate = BestGrabCandidate;
+	BestGrabCandidate = NewCandidate;
+	OnBestGrabCandidateChanged(NewCandidate, PreviousCandidate);
+}
+
+AActor* AVRMotionControllerHand::FindActorToGrab()
+{
+	if (bBestGrabCandidateDirty) UpdateBestGrabCandidate(); // Overlaps changed after this hand ticked
+
+	// Usually one Blueprint call confirms the best candidate. Full pass is needed only if Blueprint distances may change the order or best one is disabled in Blueprint
+	if (BestGrabCandidate && !GrabCandidates.HasBlueprintDistances() && !FVRInterfaceDispatch::IsGrabDisabled(BestGrabCandidate)) return BestGrabCandidate;
+
+	const int32 ActorIndex = GetClosestGrabbableActorIndex();
+	return ActorIndex != INDEX_NONE ? GrabCandidates.GetActor(ActorIndex) : nullptr;
+}
+
+TArray<AActor*> AVRMotionControllerHand::GetOverlappingActors() const
+{
+	TArray<AActor*> OverlappingActors;
+	GrabCandidates.GetActors(OverlappingActors);
+	return OverlappingActors;
 }
 
 bool AVRMotionControllerHand::TryToGrabActor()
@@ -292,15 +357,16 @@ bool AVRMotionControllerHand::TryToGrabActor()
 		return false;
 	}
 
-	int32 ActorIndex = GetClosestGrabbableActorIndex(); // How close actor is to this hand is decided by grabbable actors themselves by overriding IHandInteractable::GetWorldSquaredDistanceToMotionController() 
-	if (ActorIndex == -1) return false;
+	AActor* ActorToGrab = FindActorToGrab(); // How close actor is to this hand may be decided by grabbable actors themselves by overriding IHandInteractable::GetWorldSquaredDistanceToMotionController() 
+	if (!ActorToGrab) return false;
 
 	bIsGrabbing = true;
 
-	ConnectedActorWithHandInteractableInterface = OverlappingActorsArray[ActorIndex];
+	ConnectedActorWithHandInteractableInterface = ActorToGrab;
 	IHandInteractable::Execute_OnGrab(ConnectedActorWithHandInteractableInterface, this);
 
-	bGrabbedObjectImplementsPlayerInputInterface = ConnectedActorWithHandInteractableInterface->Implements<UVRPlayerInput>(); // Making so grabbed object may use and consume Player Input
+	bGrabbedObjectImplementsPlayerInputInterface = FVRInterfaceCache::Implements(ConnectedActorWithHandInteractableInterface, EVRInterface::PlayerInput); // Making so grabbed object may use and consume Player Input
+	RefreshInputReceivers();
 
 	return true;
 }
@@ -318,11 +384,12 @@ bool AVRMotionControllerHand::TryToReleaseGrabbedActor(bool bForceRelease)
 	}
 
 	bIsGrabbing = false;
-	//if (OverlappingActorsArray.Contains(ConnectedActorWithHandInteractableInterface)) OverlappingActorsArray.Remove(ConnectedActorWithHandInteractableInterface); // TODO Check if this is applicable in every possible situation or it should be done with some sort of check 
 
 	IHandInteractable::Execute_OnDrop(ConnectedActorWithHandInteractableInterface, this);
 	ConnectedActorWithHandInteractableInterface = nullptr;
 	bGrabbedObjectImplementsPlayerInputInterface = false;
+	RefreshInputReceivers();
+	bBestGrabCandidateDirty = true; // Hand may grab again before next tick
 
 	// Disabling collision while dropping actor so it can drop or be thrown correctly
 	HandActor->ChangeHandPhysProperties(false, true);
@@ -342,13 +409,14 @@ bool AVRMotionControllerHand::TryToReleaseGrabbedActor(bool bForceRelease)
 void AVRMotionControllerHand::StartMovingActorToHandForAttachment(AActor* ActorToAttach, FVector RelativeToMotionControllerLocation, FRotator RelativeToMotionControllerRotation)
 {
 	if (!HandActor) return;
-	if (!ActorToAttach->Implements<UHandInteractable>())
+	if (!FVRInterfaceCache::Implements(ActorToAttach, EVRInterface::HandInteractable))
 	{
 		UE_LOG(LogTemp, Error, TEXT("Trying to attach actor '%s' to hand, but no IHandInteractable interface was found!"), *ActorToAttach->GetName());
 		return;
 	}
 
 	bIsAttachmentIsInTransitionToHand = true;
+	RefreshInputReceivers();
 
 	auto HandAttachmentComponent = HandActor->GetActorAttachmentComponent();
 	if(HandAttachmentComponent) HandAttachmentComponent->SetRelativeLocationAndRotation(RelativeToMotionControllerLocation, RelativeToMotionControllerRotation);
@@ -356,6 +424,13 @@ void AVRMotionControllerHand::StartMovingActorToHandForAttachment(AActor* ActorT
 	HandActor->ChangeHandPhysProperties(false, true);
 
 	InitialAttachmentTransform = ActorToAttach->GetActorTransform();
+
+	UPrimitiveComponent* RootPrimitive = Cast<UPrimitiveComponent>(ActorToAttach->GetRootComponent());
+	if (bKinematicAttachmentTransition && RootPrimitive && RootPrimitive->IsSimulatingPhysics())
+	{
+		KinematicAttachmentComponent = RootPrimitive;
+		KinematicAttachmentComponent->SetSimulatePhysics(false); // Kinematic body follows transform set without teleport as its kinematic target
+	}
 }
 
 void AVRMotionControllerHand::AttachActorToHandImmediately(AActor* ActorToAttach/*, FVector RelativeToMotionControllerLocation, FRotator RelativeToMotionControllerRotation*/)
@@ -363,7 +438,7 @@ void AVRMotionControllerHand::AttachActorToHandImmediately(AActor* ActorToAttach
 	// TODO This function shares some code with StartMovingActorToHandForAttachment() and UpdateAttachedActorLocation() so they should be reworked
 
 	if (!HandActor) return;
-	if (!ActorToAttach->Implements<UHandInteractable>())
+	if (!FVRInterfaceCache::Implements(ActorToAttach, EVRInterface::HandInteractable))
 	{
 		UE_LOG(LogTemp, Error, TEXT("Trying to attach actor '%s' to hand, but no IHandInteractable interface was found!"), *ActorToAttach->GetName());
 		return;
@@ -407,10 +482,17 @@ void AVRMotionControllerHand::UpdateAttachedActorLocation(float DeltaTime)
 		FAttachmentTransformRules AttachmentTransformRules = FAttachmentTransformRules::KeepWorldTransform;
 		AttachmentTransformRules.bWeldSimulatedBodies = true;
 
+		if (KinematicAttachmentComponent)
+		{
+			KinematicAttachmentComponent->SetSimulatePhysics(true); // So it is welded to the hand same as without kinematic transition
+			KinematicAttachmentComponent = nullptr;
+		}
+
 		ConnectedActorWithHandInteractableInterface->AttachToActor(HandActor, AttachmentTransformRules);
 
 		CurrentAttachmentLerpValue = 0.f;
 		bIsAttachmentIsInTransitionToHand = false;
+		RefreshInputReceivers(); // Grabbed actor receives input only after it is attached
 
 		IHandInteractable::Execute_OnFinishedAttachingToHand(ConnectedActorWithHandInteractableInterface);
 
@@ -431,9 +513,11 @@ void AVRMotionControllerHand::UpdateAttachedActorLocation(float DeltaTime)
 		TargetTransform.SetScale3D(InitialAttachmentTransform.GetScale3D());
 
 		TargetTransform.SetLocation(FMath::Lerp(InitialAttachmentTransform.GetLocation(), TargetTransform.GetLocation(), CurrentAttachmentLerpValue));
-		TargetTransform.SetRotation(FMath::Lerp(InitialAttachmentTransform.GetRotation(), TargetTransform.GetRotation(), CurrentAttachmentLerpValue));
+		TargetTransform.SetRotation(FQuat::Slerp(InitialAttachmentTransform.GetRotation(), TargetTransform.GetRotation(), CurrentAttachmentLerpValue));
 
-		ConnectedActorWithHandInteractableInterface->SetActorTransform(TargetTransform, false, nullptr, ETeleportType::ResetPhysics);
+		// Kinematic body is moved to the target by physics, simulated one has to be teleported and have its velocities reset
+		const ETeleportType TeleportType = KinematicAttachmentComponent ? ETeleportType::None : ETeleportType::ResetPhysics;
+		ConnectedActorWithHandInteractableInterface->SetActorTransform(TargetTransform, false, nullptr, TeleportType);
 	}
 }
 
@@ -444,9 +528,9 @@ void AVRMotionControllerHand::OnNoCollisionOnDropTimerEnd()
 	HandActor->ChangeHandPhysProperties(true, true);
 
 	// TODO Following code must be checked in game
-	int32 ActorIndex = GetClosestGrabbableActorIndex();
+	AActor* ActorToGrab = FindActorToGrab();
 	// TODO *Comment should be changed here.* Case when we pressed grab when nothing was around to grab then moved hand close to grabbable item and reseased grab
-	if (!ConnectedActorWithHandInteractableInterface && ActorIndex != -1) IHandInteractable::Execute_OnCanBeGrabbedByHand_Start(OverlappingActorsArray[ActorIndex], this, nullptr);
+	if (!ConnectedActorWithHandInteractableInterface && ActorToGrab) FVRInterfaceDispatch::OnCanBeGrabbedByHand_Start(ActorToGrab, this, nullptr);
 }
 
 // END Logic Related to interaction with IHandInteractable Objects
\ No newline at end of file
@@ -4,12 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "VirtualRealityMotionController.h"
+#include "../Interaction/VRGrabCandidateTable.h"
 
 #include "VRMotionControllerHand.generated.h"
 
 class AHandActor;
 class AHandPhysConstraint;
 class USkeletalMeshComponent;
+class UVRInteractableGrid;
 
 /**
  * 
@@ -88,7 +90,7 @@ protected:
 	UPROPERTY(BlueprintReadWrite, Category = "Hand Motion Controller")
 	bool bHandFollowsController = false;
 
-	virtual AActor* GetActorToForwardInputTo() override;
+	virtual UObject* GetHeldInputReceiver() const override;
 	virtual bool CanDoPointingChecks() const;
 
 	// BEGIN Logic Related to interaction with IHandInteractable Objects
@@ -115,18 +117,60 @@ protected:
 	float CurrentAttachmentLerpValue = 0.f;
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Hand Motion Controller - Interaction with IHandInteractable")
 	float AttachmentTimeSec = 0.2f;
+	// Actor moving to hand is driven as kinematic body (physics interpolates it to the target every substep) instead of being teleported with physics reset every frame. Its physics simulation is restored right before it is welded to the hand
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Hand Motion Controller - Interaction with IHandInteractable")
+	bool bKinematicAttachmentTransition = false;
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Hand Motion Controller - Interaction with IHandInteractable")
 	float NoCollisionOnDropSec = 1.0f;
 
 	UPROPERTY(BlueprintReadWrite, Category = "Hand Motion Controller - Interaction with IHandInteractable")
 	AActor* ConnectedActorWithHandInteractableInterface;
-	// To pick up objects more accurately we keep array of them and ask them to provide distance to it so closest one will be picked up
-	UPROPERTY(BlueprintReadOnly, Category = "Hand Motion Controller - Interaction with IHandInteractable")
-	TArray<AActor*> OverlappingActorsArray; // TODO May need additional testing if all actors are correctly removed from this array
+	// Grab candidates are found by querying UVRInteractableGrid with hand`s grab sphere each tick instead of its overlap events, so IHandInteractable actors do not need to generate overlaps with it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hand Motion Controller - Interaction with IHandInteractable")
+	bool bUseInteractableGrid = false;
+
+	void AddGrabCandidate(AActor* Actor, UPrimitiveComponent* CollidedComponent);
+	void RemoveGrabCandidate(AActor* Actor, UPrimitiveComponent* CollidedComponent);
+	// Same begin and end semantics as grab sphere overlaps: candidates end when grab sphere stops generating overlaps (see AHandActor::ChangeHandPhysProperties)
+	void UpdateGridGrabCandidates();
+
+	UPROPERTY()
+	UVRInteractableGrid* InteractableGrid = nullptr;
+	UPROPERTY()
+	UPrimitiveComponent* GrabSphereComponent = nullptr;
+	TArray<AActor*> GridQueryActors;
+	TArray<AActor*> GridPreviousActors;
+
+	// To pick up objects more accurately we keep set of overlapping actors (each counted once, with count of its overlapping components) and pick the closest one (see FVRGrabCandidateTable)
+	mutable FVRGrabCandidateTable GrabCandidates;
+
+	// Every overlapping IHandInteractable actor once, in the order GetClosestGrabbableActorIndex() indexes them
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Hand Motion Controller - Interaction with IHandInteractable")
+	TArray<AActor*> GetOverlappingActors() const;
+	// Deprecated, use GetOverlappingActors(). Kept so Blueprints that read it still compile, reading it calls GetOverlappingActors()
+	UPROPERTY(BlueprintGetter = GetOverlappingActors, Category = "Hand Motion Controller - Interaction with IHandInteractable")
+	TArray<AActor*> OverlappingActorsArray;
 
 	UFUNCTION(BlueprintCallable, Category = "Hand Motion Controller - Interaction with IHandInteractable")
 	int32 GetClosestGrabbableActorIndex() const;
 
+	// Closest grabbable actor kept current every tick while hand is empty, so grab does not search for it. Null if there is nothing to grab.
+	// Only native checks are done every tick: Blueprint GetWorldSquaredDistanceToMotionController() and IsGrabDisabled() are asked on grab, so actor that gets grabbed may differ from this one if they are used
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Hand Motion Controller - Interaction with IHandInteractable")
+	AActor* GetBestGrabCandidate() const { return BestGrabCandidate; }
+
+	// Called when actor that will be grabbed on grab input changes (f.e. to highlight it). Any of them may be null
+	UFUNCTION(BlueprintImplementableEvent, Category = "Hand Motion Controller Events")
+	void OnBestGrabCandidateChanged(AActor* NewCandidate, AActor* PreviousCandidate);
+
+	void UpdateBestGrabCandidate();
+	// Best candidate checked with Blueprint overrides, called on grab
+	AActor* FindActorToGrab();
+
+	UPROPERTY()
+	AActor* BestGrabCandidate = nullptr;
+	bool bBestGrabCandidateDirty = false; // Candidates were added or removed since last update
+
 	UFUNCTION(BlueprintCallable, Category = "Hand Motion Controller - Interaction with IHandInteractable")
 	void StartMovingActorToHandForAttachment(AActor* ActorToAttach, FVector RelativeToMotionControllerLocation, FRotator RelativeToMotionControllerRotation);
 
@@ -138,6 +182,10 @@ protected:
 
 	bool bGrabbedObjectImplementsPlayerInputInterface;
 
+	// Root of actor in kinematic transition that simulated physics before it (see bKinematicAttachmentTransition)
+	UPROPERTY()
+	UPrimitiveComponent* KinematicAttachmentComponent = nullptr;
+
 	// END Logic Related to interaction with IHandInteractable Objects
 
 private:
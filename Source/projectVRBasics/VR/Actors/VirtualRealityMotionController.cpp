@@ -5,9 +5,18 @@
 
 #include "MotionControllerComponent.h"
 #include "UObject/ScriptInterface.h"
+#include "Engine/Engine.h"
+#include "EngineUtils.h"
+#include "WorldCollision.h"
 
 #include "Interfaces/ControllerPointable.h"
+#include "Interfaces/VRInterfaceDispatch.h"
+#include "Interfaces/VRInterfaceCache.h"
 #include "../States/ControllerState.h"
+#include "../Input/VRInputLatencyTracker.h"
+#include "../Subsystems/VRPointableRegistry.h"
+#include "ActorComponents/VRPointingProxyComponent.h"
+#include "ActorComponents/VRPointableWidgetComponent.h"
 #include "VirtualRealityPawn.h"
 
 
@@ -31,24 +40,36 @@ void AVirtualRealityMotionController::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (bPointAtProxiesOnly)
+	{
+		UVRPointableRegistry* PointableRegistry = GetWorld()->GetSubsystem<UVRPointableRegistry>();
+		if (PointableRegistry) PointableRegistry->SetPointingProxiesEnabled(true);
+	}
+
 	ChangeToDefaultState(false);
 }
 
 void AVirtualRealityMotionController::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	PushInputHistorySample(); // Before FlushInputFrame() resets this frame`s button events
+	FlushInputFrame(); // Pawn already processed this frame`s input (controllers tick after it), so receivers get it before any state logic runs
+	if (GestureSettings.IsAnyGestureEnabled()) UpdateGestures();
 	if (ControllerState) ControllerState->Tick(DeltaTime);
 
-	UpdateActorThatItPointsTo(); // Doing a Raycast to determine if we have an object we can interact with (f.e forward input to world placed UI or grabbable objects)
+	if (!bPointingBatchedByPawn) UpdateActorThatItPointsTo(); // Doing a Raycast to determine if we have an object we can interact with (f.e forward input to world placed UI or grabbable objects)
 }
 
 void AVirtualRealityMotionController::Destroyed()
 {
 	Super::Destroyed();
 
+	UpdatePointedWidget(nullptr, FVector::ZeroVector);
+
 	if (PointedAtActorWithPointableInterface.IsValid()) // TODO Check if that is enough
 	{
-		IControllerPointable::Execute_OnEndPointed(PointedAtActorWithPointableInterface.Get(), this);
+		FVRInterfaceDispatch::OnEndPointed(PointedAtActorWithPointableInterface.Get(), this);
 		PointedAtActorWithPointableInterface.Reset();
 	}
 }
@@ -68,6 +89,22 @@ void AVirtualRealityMotionController::InitialSetup(AVirtualRealityPawn* PawnOwne
 	OnDoneInitByPawn();
 }
 
+void AVirtualRealityMotionController::StartTrackingReplay()
+{
+	bTrackingReplayed = true;
+	MotionController->Deactivate(); // Otherwise it would keep polling a device that is not there
+}
+
+FTransform AVirtualRealityMotionController::GetTrackedRelativeTransform() const
+{
+	return MotionController->GetRelativeTransform();
+}
+
+void AVirtualRealityMotionController::SetReplayedTrackedTransform(const FTransform& RelativeTransform)
+{
+	if (bTrackingReplayed) MotionController->SetRelativeTransform(RelativeTransform);
+}
+
 void AVirtualRealityMotionController::PairControllers(AVirtualRealityMotionController* AnotherMotionController)
 {
 	ControllerState->SetOtherControllerReference(AnotherMotionController->GetControllerState());
@@ -121,6 +158,9 @@ void AVirtualRealityMotionController::ChangeState(TSubclassOf<UControllerState>
 		UE_LOG(LogTemp, Error, TEXT("Trying to create undefined state on %s. Empty State was created instead. Input will not work"), *this->GetName());
 		ControllerState = NewObject<UControllerState>();
 	}
+
+	GestureRecognizer.Reset(); // Gesture started in previous state should not be finished in the new one
+	RefreshInputReceivers();
 }
 
 void AVirtualRealityMotionController::ChangeToDefaultState(bool NotifyPairedControllerIfAble)
@@ -169,211 +209,413 @@ bool AVirtualRealityMotionController::IsRightHandController()
 	return IsRightController;
 }
 
-AActor* AVirtualRealityMotionController::GetActorToForwardInputTo()
+UObject* AVirtualRealityMotionController::GetHeldInputReceiver() const
 {
-	if (bPointedAtActorImplementsInputInterface) return PointedAtActorWithPointableInterface.Get();
-	else return nullptr;
+	return nullptr;
 }
 
 void AVirtualRealityMotionController::UpdateActorThatItPointsTo()
 {
-	if (CanDoPointingChecks())
+	FVector TraceStart;
+	FVector TraceEnd;
+	if (!PreparePointingTrace(TraceStart, TraceEnd)) return;
+
+	if (!bAsyncPointingTrace)
 	{
 		FHitResult HitResult;
-		FVector EndTraceLocation = GetPointingWorldTransform().GetLocation() + GetPointingWorldTransform().GetRotation().Vector() * PointingMaxDistance;
+		bool TraceHit = TracePointing(TraceStart, TraceEnd, HitResult);
+		FinishPointingTrace(TraceStart, TraceEnd, TraceHit ? &HitResult : nullptr);
+		return;
+	}
 
-		bool TraceHit = GetWorld()->LineTraceSingleByProfile(HitResult, GetPointingWorldTransform().GetLocation(), EndTraceLocation, PointingRaycastProfileName);
-		if (TraceHit && HitResult.Actor.IsValid() && HitResult.Actor.Get()->Implements<UControllerPointable>())
-		{
-			// Have A valid Hit
+	// Async: result of previous frame`s trace is applied and trace for the next frame is requested. Pointed actor is one frame late
+	FTraceDatum TraceData;
+	const bool bHasResult = PointingTraceHandle.IsValid() && GetWorld()->QueryTraceData(PointingTraceHandle, TraceData);
 
-			// Notifying previous actor the we ended pointing at it
-			if (PointedAtActorWithPointableInterface.IsValid() && PointedAtActorWithPointableInterface.Get() != HitResult.Actor.Get())
-			{
-				IControllerPointable::Execute_OnEndPointed(PointedAtActorWithPointableInterface.Get(), this);
-				
-				bPointedAtActorImplementsInputInterface = HitResult.Actor.Get()->Implements<UVRPlayerInput>();
-			}
+	PointingTraceHandle = bPointAtProxiesOnly
+		? GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd, ECC_VRPointing)
+		: GetWorld()->AsyncLineTraceByProfile(EAsyncTraceType::Single, TraceStart, TraceEnd, PointingRaycastProfileName);
 
-			if (!PointedAtActorWithPointableInterface.IsValid()) bPointedAtActorImplementsInputInterface = HitResult.Actor.Get()->Implements<UVRPlayerInput>();
+	if (bHasResult)
+	{
+		FHitResult* HitResult = TraceData.OutHits.Num() > 0 && TraceData.OutHits[0].bBlockingHit ? &TraceData.OutHits[0] : nullptr;
+		FinishPointingTrace(TraceData.Start, TraceData.End, HitResult);
+	}
+}
 
-			PointedAtActorWithPointableInterface = HitResult.Actor;
+bool AVirtualRealityMotionController::TracePointing(const FVector& TraceStart, const FVector& TraceEnd, FHitResult& OutHitResult) const
+{
+	if (bPointAtProxiesOnly) return GetWorld()->LineTraceSingleByChannel(OutHitResult, TraceStart, TraceEnd, ECC_VRPointing);
 
-			USceneComponent* HitComponent = HitResult.Component.IsValid() ? HitResult.Component.Get() : nullptr;
+	return GetWorld()->LineTraceSingleByProfile(OutHitResult, TraceStart, TraceEnd, PointingRaycastProfileName);
+}
 
-			IControllerPointable::Execute_OnGetPointed(HitResult.Actor.Get(), this, HitComponent, HitResult.Location);
-		}
-		else if (PointedAtActorWithPointableInterface.IsValid())
-		{
-			// No Hit
-			IControllerPointable::Execute_OnEndPointed(PointedAtActorWithPointableInterface.Get(), this);
-			PointedAtActorWithPointableInterface.Reset();
-		}
+bool AVirtualRealityMotionController::PreparePointingTrace(FVector& OutStart, FVector& OutEnd)
+{
+	if (!CanDoPointingChecks())
+	{
+		PointingTraceHandle = FTraceHandle(); // Result of a trace that was requested before would be outdated
+		PointingCache.bValid = false;
+		ResetPointingStabilization();
+		ApplyPointingResult(nullptr, true);
+		return false;
 	}
-	else if (PointedAtActorWithPointableInterface.IsValid())
+
+	BuildPointingQuery(OutStart, OutEnd);
+
+	if (bSkipPointingTraceWhenStill && CanReusePointingResult(OutStart, OutEnd))
 	{
-		IControllerPointable::Execute_OnEndPointed(PointedAtActorWithPointableInterface.Get(), this);
-		PointedAtActorWithPointableInterface.Reset();
+		PointingTraceHandle = FTraceHandle();
+		ApplyPointingResult(PointingCache.bHit ? &PointingCache.HitResult : nullptr);
+		return false;
 	}
+
+	if (bCullPointingByRegistry && !IsPointableInPointingCone(OutStart, OutEnd))
+	{
+		PointingTraceHandle = FTraceHandle();
+		FinishPointingTrace(OutStart, OutEnd, nullptr); // Nothing pointable may be hit, trace is skipped
+		return false;
+	}
+
+	return true;
 }
 
-// Input from Pawn. See VirtualRealityPawn.h for more details
+void AVirtualRealityMotionController::FinishPointingTrace(const FVector& TraceStart, const FVector& TraceEnd, const FHitResult* HitResult)
+{
+	CachePointingResult(TraceStart, TraceEnd, HitResult);
+	ApplyPointingResult(HitResult);
+}
 
-void AVirtualRealityMotionController::PawnInput_Axis_Thumbstick_X(float Value)
+void AVirtualRealityMotionController::SetPointingBatchedByPawn(bool bBatched)
 {
-	if (Value == Axis_Thumbstick_X_Value) return; // To reduce calls so 0, 0 and others wont trigger events continiously
-	Axis_Thumbstick_X_Value = Value; // storing value for use in BP
-	
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
-	{
-		IVRPlayerInput::Execute_Input_Axis_Thumbstick(ActorToForwardInputTo, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value); // Forwarding input to some connected actor first 
+	bPointingBatchedByPawn = bBatched && !bAsyncPointingTrace; // Both are opt-in, async trace already takes the trace off game thread
+	if (bPointingBatchedByPawn) PointingTraceHandle = FTraceHandle(); // Async trace of own Tick is not used anymore
+}
+
+bool AVirtualRealityMotionController::CanReusePointingResult(const FVector& TraceStart, const FVector& TraceEnd) const
+{
+	if (!PointingCache.bValid) return false;
+	if (GetWorld()->GetTimeSeconds() - PointingCache.Time > PointingForcedRefreshInterval) return false;
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if(!ConsumeInputParams.Axes.Thumbstick) if (ControllerState) ControllerState->Execute_Input_Axis_Thumbstick(ControllerState, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value); // Forwarding input to controller state if input was not consumed by another actor
+	if (FVector::DistSquared(TraceStart, PointingCache.TraceStart) > FMath::Square(PointingStillLinearEpsilon)) return false;
+
+	const FVector Direction = (TraceEnd - TraceStart).GetSafeNormal();
+	if (FVector::DotProduct(Direction, PointingCache.TraceDirection) < FMath::Cos(FMath::DegreesToRadians(PointingStillAngularEpsilon))) return false;
+
+	if (PointingCache.bHit)
+	{
+		// Hit actor moved, so hit location is outdated. Moving actors that are not hit are caught by forced refresh only
+		AActor* HitActor = PointingCache.HitResult.Actor.Get();
+		if (!HitActor || !HitActor->GetActorTransform().Equals(PointingCache.HitActorTransform, KINDA_SMALL_NUMBER)) return false;
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Axis_Thumbstick(ControllerState, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value); // Forwarding input to controller state if ControllerState is valid
 
-	Execute_Input_Axis_Thumbstick(this, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value); // call to BP event
+	return true;
 }
 
-void AVirtualRealityMotionController::PawnInput_Axis_Thumbstick_Y(float Value)
+void AVirtualRealityMotionController::CachePointingResult(const FVector& TraceStart, const FVector& TraceEnd, const FHitResult* HitResult)
 {
-	if (Value == Axis_Thumbstick_Y_Value) return;
-	Axis_Thumbstick_Y_Value = Value;
-	
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
-	{
-		IVRPlayerInput::Execute_Input_Axis_Thumbstick(ActorToForwardInputTo, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value);
+	if (!bSkipPointingTraceWhenStill) return;
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Axes.Thumbstick) if (ControllerState) ControllerState->Execute_Input_Axis_Thumbstick(ControllerState, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value);
-	}
-	else if (ControllerState) ControllerState->Execute_Input_Axis_Thumbstick(ControllerState, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value);
+	PointingCache.bValid = true;
+	PointingCache.Time = GetWorld()->GetTimeSeconds();
+	PointingCache.TraceStart = TraceStart;
+	PointingCache.TraceDirection = (TraceEnd - TraceStart).GetSafeNormal();
 
-	Execute_Input_Axis_Thumbstick(this, Axis_Thumbstick_X_Value, Axis_Thumbstick_Y_Value);
+	AActor* HitActor = HitResult ? HitResult->Actor.Get() : nullptr;
+	PointingCache.bHit = HitActor != nullptr;
+	if (HitActor)
+	{
+		PointingCache.HitResult = *HitResult;
+		PointingCache.HitActorTransform = HitActor->GetActorTransform();
+	}
 }
 
-void AVirtualRealityMotionController::PawnInput_Axis_Trigger(float Value)
+void AVirtualRealityMotionController::BuildPointingQuery(FVector& OutStart, FVector& OutEnd)
 {
-	if (Value == Axis_Trigger_Value) return;
-	Axis_Trigger_Value = Value;
+	const FTransform PointingTransform = GetPointingWorldTransform();
+	OutStart = PointingTransform.GetLocation();
+	FVector Direction = PointingTransform.GetRotation().Vector();
 
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
+	if (bFilterPointing)
 	{
-		IVRPlayerInput::Execute_Input_Axis_Trigger(ActorToForwardInputTo, Axis_Trigger_Value);
+		// Filtered relative to this actor, it is attached to pawn`s VR root, so teleports and locomotion are not smoothed
+		const FTransform& ReferenceTransform = GetActorTransform();
+		FVector RelativeStart = ReferenceTransform.InverseTransformPosition(OutStart);
+		FVector RelativeDirection = ReferenceTransform.InverseTransformVectorNoScale(Direction);
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Axes.Trigger) if (ControllerState) ControllerState->Execute_Input_Axis_Trigger(ControllerState, Axis_Trigger_Value);
+		PointingFilter.Filter(RelativeStart, RelativeDirection, GetWorld()->GetDeltaSeconds(), PointingFilterSettings);
+
+		OutStart = ReferenceTransform.TransformPosition(RelativeStart);
+		Direction = ReferenceTransform.TransformVectorNoScale(RelativeDirection);
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Axis_Trigger(ControllerState, Axis_Trigger_Value);
 
-	Execute_Input_Axis_Trigger(this, Axis_Trigger_Value);
+	LastPointingStart = OutStart;
+	LastPointingDirection = Direction;
+	OutEnd = OutStart + Direction * PointingMaxDistance;
 }
 
-void AVirtualRealityMotionController::PawnInput_Axis_Grip(float Value)
+bool AVirtualRealityMotionController::ShouldSwitchPointedTarget(AActor* NewTarget)
 {
-	if (Value == Axis_Grip_Value) return;
-	Axis_Grip_Value = Value;
+	AActor* CurrentTarget = PointedAtActorWithPointableInterface.Get();
 
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
+	// Nothing to keep, pointing begins right away
+	if (NewTarget == CurrentTarget || !CurrentTarget || PointingTargetSwitchFrames <= 0)
 	{
-		IVRPlayerInput::Execute_Input_Axis_Grip(ActorToForwardInputTo, Axis_Grip_Value);
+		PendingPointedTarget.Reset();
+		PendingPointedTargetFrames = 0;
+		return true;
+	}
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Axes.Grip) if (ControllerState) ControllerState->Execute_Input_Axis_Grip(ControllerState, Axis_Grip_Value);
+	if (PendingPointedTargetFrames == 0 || PendingPointedTarget.Get() != NewTarget)
+	{
+		PendingPointedTarget = NewTarget;
+		PendingPointedTargetFrames = 0;
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Axis_Grip(ControllerState, Axis_Grip_Value);
+	++PendingPointedTargetFrames;
+
+	// Last point where current target was hit tells how far ray turned away from it
+	const FVector ToCurrentTarget = (PointedTargetLocation - LastPointingStart).GetSafeNormal();
+	const bool bTurnedAway = FVector::DotProduct(ToCurrentTarget, LastPointingDirection) < FMath::Cos(FMath::DegreesToRadians(PointingTargetSwitchAngle));
 
-	Execute_Input_Axis_Grip(this, Axis_Grip_Value);
+	if (PendingPointedTargetFrames < PointingTargetSwitchFrames && !bTurnedAway) return false;
+
+	PendingPointedTarget.Reset();
+	PendingPointedTargetFrames = 0;
+	return true;
+}
+
+void AVirtualRealityMotionController::ResetPointingStabilization()
+{
+	PointingFilter.Reset();
+	PendingPointedTarget.Reset();
+	PendingPointedTargetFrames = 0;
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_Primary(EButtonActionType ActionType)
+bool AVirtualRealityMotionController::IsPointableInPointingCone(const FVector& TraceStart, const FVector& TraceEnd) const
 {
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
+	UVRPointableRegistry* PointableRegistry = GetWorld()->GetSubsystem<UVRPointableRegistry>();
+	if (!PointableRegistry) return true;
+
+	return PointableRegistry->HasPointableInCone(TraceStart, (TraceEnd - TraceStart).GetSafeNormal(), PointingMaxDistance, PointingCullingConeHalfAngle);
+}
+
+void AVirtualRealityMotionController::ApplyPointingResult(const FHitResult* HitResult, bool bImmediate)
+{
+	AActor* PreviousPointedAtActor = PointedAtActorWithPointableInterface.Get();
+	AActor* HitActor = HitResult ? HitResult->Actor.Get() : nullptr;
+	if (HitActor && !FVRInterfaceCache::Implements(HitActor, EVRInterface::ControllerPointable)) HitActor = nullptr;
+
+	if (!bImmediate && !ShouldSwitchPointedTarget(HitActor)) return; // Current target is kept for now, without hover updates
+
+	if (HitActor)
 	{
-		IVRPlayerInput::Execute_Input_Button_Primary(ActorToForwardInputTo, ActionType);
+		// Have A valid Hit
+
+		// Notifying previous actor the we ended pointing at it
+		if (PreviousPointedAtActor && PreviousPointedAtActor != HitActor) FVRInterfaceDispatch::OnEndPointed(PreviousPointedAtActor, this);
+		const bool bPointingBegins = PreviousPointedAtActor != HitActor;
+		if (bPointingBegins)
+		{
+			bPointedAtActorImplementsInputInterface = FVRInterfaceCache::Implements(HitActor, EVRInterface::PlayerInput);
+
+			const float MaxRate = bThrottlePointedHover ? FVRInterfaceDispatch::GetPointedHoverMaxRate(HitActor) : 0.f;
+			const float EffectiveMaxRate = MaxRate > 0.f ? MaxRate : PointedHoverMaxRate;
+			PointedHoverMinInterval = EffectiveMaxRate > 0.f ? 1.f / EffectiveMaxRate : 0.f;
+		}
+
+		PointedAtActorWithPointableInterface = HitActor;
+		PointedTargetLocation = HitResult->Location;
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Buttons.Primary) if (ControllerState) ControllerState->Execute_Input_Button_Primary(ControllerState, ActionType);
+		USceneComponent* HitComponent = UVRPointingProxyComponent::ResolveHitComponent(HitResult->Component.Get());
+		UpdatePointedWidget(HitComponent, HitResult->Location); // Native and cheap, so not throttled
+
+		if (bPointingBegins || ShouldSendPointedHover(HitComponent, HitResult->Location))
+		{
+			PointedHoverComponent = HitComponent;
+			PointedHoverLocation = HitResult->Location;
+			PointedHoverTime = GetWorld()->GetTimeSeconds();
+
+			FVRInterfaceDispatch::OnGetPointed(HitActor, this, HitComponent, HitResult->Location);
+		}
+	}
+	else if (PreviousPointedAtActor)
+	{
+		// No Hit
+		UpdatePointedWidget(nullptr, FVector::ZeroVector);
+		FVRInterfaceDispatch::OnEndPointed(PreviousPointedAtActor, this);
+		PointedAtActorWithPointableInterface.Reset();
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Button_Primary(ControllerState, ActionType);
 
-	Execute_Input_Button_Primary(this, ActionType);
+	if (PreviousPointedAtActor != PointedAtActorWithPointableInterface.Get()) RefreshInputReceivers(); // Input target changed
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_Secondary(EButtonActionType ActionType)
+void AVirtualRealityMotionController::UpdatePointedWidget(USceneComponent* HitComponent, const FVector& HitLocation)
 {
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
+	UVRPointableWidgetComponent* HitWidget = Cast<UVRPointableWidgetComponent>(HitComponent);
+	UVRPointableWidgetComponent* PreviousWidget = PointedWidget.Get();
+
+	if (PreviousWidget && PreviousWidget != HitWidget) PreviousWidget->EndPointer(this);
+
+	PointedWidget = HitWidget;
+	if (HitWidget) HitWidget->UpdatePointer(this, HitLocation);
+}
+
+bool AVirtualRealityMotionController::ShouldSendPointedHover(const USceneComponent* HitComponent, const FVector& HitLocation) const
+{
+	if (!bThrottlePointedHover) return true;
+
+	// Location is compared to the last sent one, so last movement is delivered once rate limit allows it
+	const bool bChanged = PointedHoverComponent.Get() != HitComponent || FVector::DistSquared(PointedHoverLocation, HitLocation) > FMath::Square(PointedHoverLocationThreshold);
+	if (!bChanged) return false;
+
+	return GetWorld()->GetTimeSeconds() - PointedHoverTime >= PointedHoverMinInterval;
+}
+
+// Input from Pawn. See VirtualRealityPawn.h for more details
+
+namespace VRControllerInput
+{
+	static EVRInputLatencyStage GetLatencyStage(int32 Slot)
 	{
-		IVRPlayerInput::Execute_Input_Button_Secondary(ActorToForwardInputTo, ActionType);
+		switch (static_cast<EVRInputReceiverSlot>(Slot))
+		{
+		case EVRInputReceiverSlot::ControllerState: return EVRInputLatencyStage::ControllerState;
+		case EVRInputReceiverSlot::Controller: return EVRInputLatencyStage::ControllerBlueprint;
+		default: return EVRInputLatencyStage::ForwardedActor;
+		}
+	}
+}
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Buttons.Secondary) if (ControllerState) ControllerState->Execute_Input_Button_Secondary(ControllerState, ActionType);
+float& AVirtualRealityMotionController::GetAxisValueRef(EVRInputAxis Axis)
+{
+	switch (Axis)
+	{
+	case EVRInputAxis::Thumbstick_X: return Axis_Thumbstick_X_Value;
+	case EVRInputAxis::Thumbstick_Y: return Axis_Thumbstick_Y_Value;
+	case EVRInputAxis::Trigger: return Axis_Trigger_Value;
+	default: return Axis_Grip_Value;
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Button_Secondary(ControllerState, ActionType);
+}
+
+void AVirtualRealityMotionController::PawnInput_Axis(EVRInputAxis Axis, float Value)
+{
+	const bool bAxisAlreadyChanged = InputFrame.IsAxisChanged(Axis);
+	if (!InputFrame.SetAxis(Axis, Value)) return; // To reduce calls so 0, 0 and others wont trigger events continiously
+	GetAxisValueRef(Axis) = Value; // storing value for use in BP
+
+	FVRInputLatencyTracker::OnReceived();
+	if (!bAxisAlreadyChanged) AxisReceiveTimes[VRInput::ToIndex(Axis)] = FVRInputLatencyTracker::GetReceiveTime(); // Latency of an axis is counted from its first change in this frame
 
-	Execute_Input_Button_Secondary(this, ActionType);
+	// Axis events are sent from FlushInputFrame() so thumbstick X and Y are received together once per frame
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_Thumbstick(EButtonActionType ActionType)
+void AVirtualRealityMotionController::PawnInput_Button(EVRInputButton Button, EButtonActionType ActionType)
 {
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
+	InputFrame.AddButtonEvent(Button, ActionType); // Button events are still sent right away, frame only keeps track of them
+
+	FVRInputLatencyTracker::OnReceived();
+	const double ReceiveTime = FVRInputLatencyTracker::GetReceiveTime();
+
+	// Receivers are taken before sending, so receiver that appears because of this event (f.e. object grabbed on Grip press) does not get it
+	const uint8 Routes = InputReceivers.GetButtonRoutes(Button);
+	UObject* Receivers[FVRInputReceiverStack::NumSlots];
+	for (int32 Slot = 0; Slot < FVRInputReceiverStack::NumSlots; ++Slot) Receivers[Slot] = (Routes & FVRInputReceiverStack::SlotBit(Slot)) ? InputReceivers.GetReceiver(Slot) : nullptr;
+
+	for (int32 Slot = 0; Slot < FVRInputReceiverStack::NumSlots; ++Slot)
 	{
-		IVRPlayerInput::Execute_Input_Button_Thumbstick(ActorToForwardInputTo, ActionType);
+		if (!Receivers[Slot]) continue;
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Buttons.Thumbstick) if (ControllerState) ControllerState->Execute_Input_Button_Thumbstick(ControllerState, ActionType);
+		FVRInputLatencyTracker::OnDelivered(VRControllerInput::GetLatencyStage(Slot), ReceiveTime);
+		FVRInterfaceDispatch::Input_Button(Receivers[Slot], Button, ActionType);
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Button_Thumbstick(ControllerState, ActionType);
+}
+
+void AVirtualRealityMotionController::RefreshInputReceivers()
+{
+	InputReceivers.SetReceiver(EVRInputReceiverSlot::HeldObject, GetHeldInputReceiver());
+	InputReceivers.SetReceiver(EVRInputReceiverSlot::PointedObject, bPointedAtActorImplementsInputInterface ? PointedAtActorWithPointableInterface.Get() : nullptr);
+	InputReceivers.SetReceiver(EVRInputReceiverSlot::ControllerState, ControllerState);
+	InputReceivers.SetReceiver(EVRInputReceiverSlot::Controller, this);
 
-	Execute_Input_Button_Thumbstick(this, ActionType);
+	if (InputReceivers.IsDirty()) InputReceivers.Rebuild();
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_Trigger(EButtonActionType ActionType)
+void AVirtualRealityMotionController::InvalidateConsumeInputParams()
 {
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
+	InputReceivers.Invalidate();
+	RefreshInputReceivers();
+}
+
+void AVirtualRealityMotionController::InvalidateConsumeInputParamsOfActor(const UObject* WorldContextObject, AActor* TargetActor)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (!World || !TargetActor) return;
+
+	for (TActorIterator<AVirtualRealityMotionController> It(World); It; ++It)
 	{
-		IVRPlayerInput::Execute_Input_Button_Trigger(ActorToForwardInputTo, ActionType);
+		if (It->InputReceivers.Contains(TargetActor)) It->InvalidateConsumeInputParams();
+	}
+}
+
+void AVirtualRealityMotionController::FlushInputFrame()
+{
+	RefreshInputReceivers(); // Receivers are normally refreshed when they change, this only catches ones that were changed from BPs directly
+	if (!InputFrame.HasChanges()) return;
+
+	const bool bTrackLatency = FVRInputLatencyTracker::IsEnabled();
+	const uint32 AllControlsMask = VRInput::AllAxesMask | VRInput::AllButtonsMask;
+
+	UObject* Receivers[FVRInputReceiverStack::NumSlots];
+	for (int32 Slot = 0; Slot < FVRInputReceiverStack::NumSlots; ++Slot) Receivers[Slot] = InputReceivers.GetRouteMask(Slot) ? InputReceivers.GetReceiver(Slot) : nullptr;
+
+	for (int32 Slot = 0; Slot < FVRInputReceiverStack::NumSlots; ++Slot)
+	{
+		if (!Receivers[Slot]) continue;
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Buttons.Trigger) if (ControllerState) ControllerState->Execute_Input_Button_Trigger(ControllerState, ActionType);
+		FVRInputFrame ReceiverFrame = InputFrame;
+		ReceiverFrame.ClearControls(AllControlsMask & ~InputReceivers.GetRouteMask(Slot)); // Receiver does not see controls that go to others only
+
+		if (bTrackLatency) FVRInputLatencyTracker::OnFrameDelivered(VRControllerInput::GetLatencyStage(Slot), ReceiverFrame, AxisReceiveTimes);
+		DeliverInputFrame(Receivers[Slot], ReceiverFrame);
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Button_Trigger(ControllerState, ActionType);
 
-	Execute_Input_Button_Trigger(this, ActionType);
+	InputFrame.ResetChanges();
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_Grip(EButtonActionType ActionType)
+void AVirtualRealityMotionController::DeliverInputFrame(UObject* Target, const FVRInputFrame& Frame) const
 {
-	AActor* ActorToForwardInputTo = GetActorToForwardInputTo();
-	if (ActorToForwardInputTo)
-	{
-		IVRPlayerInput::Execute_Input_Button_Grip(ActorToForwardInputTo, ActionType);
+	if (!Frame.HasChanges()) return;
 
-		FConsumeInputParams ConsumeInputParams = IVRPlayerInput::Execute_GetConsumeInputParams(ActorToForwardInputTo);
-		if (!ConsumeInputParams.Buttons.Grip) if (ControllerState) ControllerState->Execute_Input_Button_Grip(ControllerState, ActionType);
+	if (bSendAxisEvents)
+	{
+		if (Frame.IsAxisChanged(EVRInputAxis::Thumbstick_X) || Frame.IsAxisChanged(EVRInputAxis::Thumbstick_Y)) FVRInterfaceDispatch::Input_Axis_Thumbstick(Target, Frame.Thumbstick_X, Frame.Thumbstick_Y);
+		if (Frame.IsAxisChanged(EVRInputAxis::Trigger)) FVRInterfaceDispatch::Input_Axis_Trigger(Target, Frame.Trigger);
+		if (Frame.IsAxisChanged(EVRInputAxis::Grip)) FVRInterfaceDispatch::Input_Axis_Grip(Target, Frame.Grip);
 	}
-	else if (ControllerState) ControllerState->Execute_Input_Button_Grip(ControllerState, ActionType);
 
-	Execute_Input_Button_Grip(this, ActionType);
+	if (bSendInputFrameEvent) FVRInterfaceDispatch::Input_Frame(Target, Frame);
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_Menu(EButtonActionType ActionType)
+void AVirtualRealityMotionController::PushInputHistorySample()
 {
-	if (ControllerState) ControllerState->Execute_Input_Button_Menu(ControllerState, ActionType);
-	Execute_Input_Button_Menu(this, ActionType);
+	FVRInputHistorySample Sample;
+	Sample.Time = GetWorld()->GetTimeSeconds();
+	Sample.Thumbstick = FVector2D(InputFrame.Thumbstick_X, InputFrame.Thumbstick_Y);
+	Sample.Trigger = InputFrame.Trigger;
+	Sample.Grip = InputFrame.Grip;
+	Sample.ButtonStateMask = InputFrame.ButtonStateMask;
+	Sample.PressedEventsMask = (InputFrame.ButtonEventsMask >> (static_cast<int32>(EButtonActionType::Pressed) * VRInput::ButtonEventBitsPerAction)) & ((1 << VRInput::ButtonEventBitsPerAction) - 1);
+
+	Sample.Location = MotionController->GetRelativeLocation();
+
+	InputHistory.Push(Sample);
 }
 
-void AVirtualRealityMotionController::PawnInput_Button_System(EButtonActionType ActionType)
+void AVirtualRealityMotionController::UpdateGestures()
 {
-	if (ControllerState) ControllerState->Execute_Input_Button_System(ControllerState, ActionType);
-	Execute_Input_Button_System(this, ActionType);
-}
\ No newline at end of file
+	TArray<FVRGestureEvent, TInlineAllocator<4>> GestureEvents;
+	GestureRecognizer.Update(InputHistory, GestureSettings, GestureEvents);
+
+	if (!ControllerState) return;
+	for (const FVRGestureEvent& GestureEvent : GestureEvents) ControllerState->OnGesture(GestureEvent);
+}
@@ -4,14 +4,21 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "WorldCollision.h"
 
 #include "Interfaces/VRPlayerInput.h"
+#include "../Input/VRInputTypes.h"
+#include "../Input/VRInputHistory.h"
+#include "../Input/VRGestureRecognizer.h"
+#include "../Input/VRInputReceiverStack.h"
+#include "../Input/VRPointingFilter.h"
 
 #include "VirtualRealityMotionController.generated.h"
 
 class AVirtualRealityPawn;
 class UControllerState;
 class USplineComponent;
+class UVRPointableWidgetComponent;
 
 
 UCLASS(Blueprintable, abstract)
@@ -65,6 +72,12 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "Override")
 	void SetControllerVisibility(bool bVisible) const;
 
+	// Input replay (see FVRInputRecorder). Motion controller component stops polling XR device and its transform is set by pawn every frame
+	void StartTrackingReplay();
+	bool IsTrackingReplayed() const { return bTrackingReplayed; }
+	FTransform GetTrackedRelativeTransform() const;
+	void SetReplayedTrackedTransform(const FTransform& RelativeTransform);
+
 protected:
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup")
@@ -72,6 +85,9 @@ protected:
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
 	FName PointingRaycastProfileName;
+	// Pointing trace uses VRPointing channel instead of PointingRaycastProfileName, so it hits only simple proxies of pointable actors and occluders that block that channel (see UVRPointingProxyComponent)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
+	bool bPointAtProxiesOnly = false;
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
 	float PointingMaxDistance;
 
@@ -90,12 +106,13 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category = "Motion Controller Events")
 	void OnDoneInitByPawn();
 
-	UFUNCTION()
-	virtual AActor* GetActorToForwardInputTo();
+	// Object that receives input with the highest priority because it is held by this controller (see FVRInputReceiverStack)
+	virtual UObject* GetHeldInputReceiver() const;
 	UFUNCTION()
 	virtual bool CanDoPointingChecks() const { return true; }; // TODO change so it may be overrriden in BPs
 
 	bool IsRightController;
+	bool bTrackingReplayed = false;
 
 	UPROPERTY()
 	USplineComponent* SplineComponent;
@@ -105,23 +122,132 @@ protected:
 	UPROPERTY(BlueprintReadWrite, Category = "Motion Controller")
 	bool bPointedAtActorImplementsInputInterface;// Valid only if PointedAtActorWithPointableInterface implements both interfaces: UVRPlayerInput and UControllerPointable
 
+	// Pointing is done in phases: trace start and end are built, trace is done (sync or async) and its result updates pointed actor
 	UFUNCTION()
 	void UpdateActorThatItPointsTo();
+	void BuildPointingQuery(FVector& OutStart, FVector& OutEnd);
+	// bImmediate skips target hysteresis, f.e. when pointing gets disabled
+	void ApplyPointingResult(const FHitResult* HitResult, bool bImmediate = false);
+
+	// Ray of the last pointing query, filtered if bFilterPointing is set. May be used to draw pointer so it matches pointed targets
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Motion Controller")
+	void GetLastPointingRay(FVector& Start, FVector& Direction) const { Start = LastPointingStart; Direction = LastPointingDirection; }
+
+	// Pointing ray is smoothed with One Euro filter before the trace, so hand tremor does not make targets flicker
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
+	bool bFilterPointing = false;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bFilterPointing"))
+	FVRPointingFilterSettings PointingFilterSettings;
+	// Pointed actor is replaced by another one (or by nothing) only after new target was hit that many traces in a row, or if ray turned away from current target further than PointingTargetSwitchAngle. 0 switches right away
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (ClampMin = "0"))
+	int32 PointingTargetSwitchFrames = 0;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "PointingTargetSwitchFrames > 0", ClampMin = "0", Units = "deg"))
+	float PointingTargetSwitchAngle = 3.f;
+
+	bool ShouldSwitchPointedTarget(AActor* NewTarget);
+	void ResetPointingStabilization();
+
+	FVRPointingFilter PointingFilter;
+	FVector LastPointingStart = FVector::ZeroVector;
+	FVector LastPointingDirection = FVector::ForwardVector;
+	FVector PointedTargetLocation = FVector::ZeroVector; // Last hit on current pointed actor
+	TWeakObjectPtr<AActor> PendingPointedTarget;
+	int32 PendingPointedTargetFrames = 0; // 0 if there is no pending target
+
+	// OnGetPointed is sent when pointing begins and then only when hit component changes or hit location moves further than PointedHoverLocationThreshold, at most PointedHoverMaxRate times per second.
+	// If disabled, OnGetPointed is sent every frame while actor is pointed at
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
+	bool bThrottlePointedHover = true;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bThrottlePointedHover", ClampMin = "0", Units = "cm"))
+	float PointedHoverLocationThreshold = 0.5f;
+	// Per second, 0 is unlimited. Pointed actor may override it (see IControllerPointable::GetPointedHoverMaxRate)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bThrottlePointedHover", ClampMin = "0"))
+	float PointedHoverMaxRate = 0.f;
+
+	bool ShouldSendPointedHover(const USceneComponent* HitComponent, const FVector& HitLocation) const;
+
+	// Pointed UVRPointableWidgetComponent gets pointer location in widget space every pointing update
+	void UpdatePointedWidget(USceneComponent* HitComponent, const FVector& HitLocation);
+	TWeakObjectPtr<UVRPointableWidgetComponent> PointedWidget;
+
+	// Last OnGetPointed that was sent to pointed actor
+	TWeakObjectPtr<USceneComponent> PointedHoverComponent;
+	FVector PointedHoverLocation = FVector::ZeroVector;
+	double PointedHoverTime = 0.0;
+	float PointedHoverMinInterval = 0.f;
+
+	// Pointing trace is requested asynchronously and its result is used next frame. Saves game thread time, pointed actor is one frame late. Controller that uses it is not batched by pawn
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
+	bool bAsyncPointingTrace = false;
+
+	FTraceHandle PointingTraceHandle;
+
+	// Pointing trace is skipped if no IControllerPointable actor bounds are inside pointing cone (see UVRPointableRegistry).
+	// Pointables whose components or collision change without their root moving must call UVRPointableRegistry::UpdatePointableBounds, or they are missed
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
+	bool bCullPointingByRegistry = false;
+	// Wider cone keeps pointables whose bounds are slightly outdated
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bCullPointingByRegistry", ClampMin = "0", ClampMax = "45", Units = "deg"))
+	float PointingCullingConeHalfAngle = 2.f;
+
+	bool IsPointableInPointingCone(const FVector& TraceStart, const FVector& TraceEnd) const;
+
+	// Pointing trace is skipped and previous result is reused while controller stays still and hit actor does not move
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing")
+	bool bSkipPointingTraceWhenStill = false;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bSkipPointingTraceWhenStill", ClampMin = "0", Units = "cm"))
+	float PointingStillLinearEpsilon = 0.1f;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bSkipPointingTraceWhenStill", ClampMin = "0", Units = "deg"))
+	float PointingStillAngularEpsilon = 0.1f;
+	// Trace is done at least that often, so actors that moved into pointing ray are found
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Pointing", meta = (EditCondition = "bSkipPointingTraceWhenStill", ClampMin = "0", Units = "s"))
+	float PointingForcedRefreshInterval = 0.25f;
+
+	bool CanReusePointingResult(const FVector& TraceStart, const FVector& TraceEnd) const;
+	void CachePointingResult(const FVector& TraceStart, const FVector& TraceEnd, const FHitResult* HitResult);
+
+	struct FPointingCache
+	{
+		FVector TraceStart = FVector::ZeroVector;
+		FVector TraceDirection = FVector::ZeroVector;
+		FHitResult HitResult;
+		FTransform HitActorTransform;
+		double Time = 0.0;
+		bool bHit = false;
+		bool bValid = false;
+	};
+	FPointingCache PointingCache;
+
+	// BEGIN Pointing batched by Pawn
+public:
+	// Pawn traces pointing rays of both hands at once after both controllers ticked (see AVirtualRealityPawn::TickInteraction), controller does not point in its own Tick then. Controller with bAsyncPointingTrace keeps its own async trace
+	void SetPointingBatchedByPawn(bool bBatched);
+	bool IsPointingBatchedByPawn() const { return bPointingBatchedByPawn; }
+	// False if pointing result was applied without a trace (pointing is disabled, culled or reused). Otherwise ray from OutStart to OutEnd has to be traced and its result passed to FinishPointingTrace()
+	bool PreparePointingTrace(FVector& OutStart, FVector& OutEnd);
+	void FinishPointingTrace(const FVector& TraceStart, const FVector& TraceEnd, const FHitResult* HitResult);
+	// Thread safe, pawn calls it from worker threads
+	bool TracePointing(const FVector& TraceStart, const FVector& TraceEnd, FHitResult& OutHitResult) const;
+
+private:
+	bool bPointingBatchedByPawn = false;
+	// END Pointing batched by Pawn
 
 	// BEGIN Input from Pawn implementation 
 public:
-	void PawnInput_Axis_Thumbstick_X(float Value);
-	void PawnInput_Axis_Thumbstick_Y(float Value);
-	void PawnInput_Axis_Trigger(float Value);
-	void PawnInput_Axis_Grip(float Value);
-
-	void PawnInput_Button_Primary(EButtonActionType ActionType);
-	void PawnInput_Button_Secondary(EButtonActionType ActionType);
-	void PawnInput_Button_Thumbstick(EButtonActionType ActionType);
-	void PawnInput_Button_Trigger(EButtonActionType ActionType);
-	void PawnInput_Button_Grip(EButtonActionType ActionType);
-	void PawnInput_Button_Menu(EButtonActionType ActionType);
-	void PawnInput_Button_System(EButtonActionType ActionType);
+	// Single entry points for every control. Pawn looks up hand and control in its input binding table and calls these
+	void PawnInput_Axis(EVRInputAxis Axis, float Value);
+	void PawnInput_Button(EVRInputButton Button, EButtonActionType ActionType);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Motion Controller Input")
+	FVRInputFrame GetInputFrame() const { return InputFrame; }
+
+	// Consume params of objects that receive input from this controller are cached when those objects change. Object must call this if its GetConsumeInputParams() result changed
+	UFUNCTION(BlueprintCallable, Category = "Motion Controller Input")
+	void InvalidateConsumeInputParams();
+	// Same as above for every motion controller that currently sends input to TargetActor
+	UFUNCTION(BlueprintCallable, Category = "Motion Controller Input", meta = (WorldContext = "WorldContextObject"))
+	static void InvalidateConsumeInputParamsOfActor(const UObject* WorldContextObject, AActor* TargetActor);
 
 protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Motion Controller Input")
@@ -132,5 +258,48 @@ protected:
 	float Axis_Trigger_Value = 0.f;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Motion Controller Input")
 	float Axis_Grip_Value = 0.f;
+
+	// Axis changes and button events are collected here while ue4 processes input and delivered once per Tick (axes are not sent right away).
+	// Button events are still sent immediately, so receivers get Trigger press before Trigger axis value of the same frame
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Motion Controller Input")
+	FVRInputFrame InputFrame;
+
+	// Send IVRPlayerInput::Input_Frame once per Tick if anything changed. Receivers that use it may disable bSendAxisEvents, so each of them gets one event per frame
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Input")
+	bool bSendInputFrameEvent = false;
+	// Send Input_Axis_* events once per Tick for changed axes. May be disabled if all receivers use Input_Frame only
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Input")
+	bool bSendAxisEvents = true;
+
+	float& GetAxisValueRef(EVRInputAxis Axis);
+
+	// Called when held object, pointed object or controller state may have changed. Routes are recomputed only if some receiver is different
+	void RefreshInputReceivers();
+
+	void FlushInputFrame();
+	void DeliverInputFrame(UObject* Target, const FVRInputFrame& Frame) const;
+
+private:
+	FVRInputReceiverStack InputReceivers;
+
+	double AxisReceiveTimes[VRInput::NumAxes] = {}; // see FVRInputLatencyTracker
 	// END Input from Pawn implementation */
+
+	// BEGIN Gestures
+public:
+	// Last input values and locations of this hand, one sample per Tick
+	const FVRInputHistory& GetInputHistory() const { return InputHistory; }
+
+protected:
+	// Recognized gestures are sent to controller state (UControllerState::OnGesture)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Motion Controller Setup - Gestures")
+	FVRGestureSettings GestureSettings;
+
+private:
+	void PushInputHistorySample();
+	void UpdateGestures();
+
+	FVRInputHistory InputHistory;
+	FVRGestureRecognizer GestureRecognizer;
+	// END Gestures
 };
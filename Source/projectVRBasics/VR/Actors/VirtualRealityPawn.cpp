@@ -5,6 +5,7 @@
 
 #include "VirtualRealityMotionController.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/InputComponent.h"
 #include "MotionControllerComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Kismet/GameplayStatics.h"
@@ -13,8 +14,13 @@
 #include "IXRSystemAssets.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/App.h"
+#include "Async/ParallelFor.h"
 
 #include "../States/ControllerState.h"
+#include "../Input/VRInputRecorder.h"
+#include "../Input/VRInputThresholdProfile.h"
 
 
 AVirtualRealityPawn::AVirtualRealityPawn()
@@ -42,6 +48,10 @@ AVirtualRealityPawn::AVirtualRealityPawn()
 
 	StartFadeTimeSec = 1.f;
 	RightControllerIsPrimary = true;
+
+	InteractionTickFunction.bCanEverTick = true;
+	InteractionTickFunction.bStartWithTickEnabled = true;
+	InteractionTickFunction.TickGroup = TG_PrePhysics;
 }
 
 void AVirtualRealityPawn::BeginPlay()
@@ -54,6 +64,10 @@ void AVirtualRealityPawn::BeginPlay()
 		PlayerController->PlayerCameraManager->SetManualCameraFade(1.0f, FLinearColor::Black, false);
 	}
 
+	ApplyInputThresholds(nullptr); // Until controller type is known
+
+	InputRecorder = FVRInputRecorder::CreateFromCommandLine();
+
 	// Starting up timer to wait for headset to update its position
 	GetWorld()->GetTimerManager().SetTimer(
 		TimerHandle_StartCameraFade,
@@ -64,8 +78,49 @@ void AVirtualRealityPawn::BeginPlay()
 	);
 }
 
+void AVirtualRealityPawn::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Frames are counted from the moment both controllers exist, so hands loading time does not shift recorded input
+	if (InputRecorder.IsValid() && InputRecorder->IsReplaying() && LeftHand && RightHand) ReplayInputFrame();
+
+	EvaluateAnalogButtons(); // Last point before controllers tick
+
+	if (InputRecorder.IsValid() && InputRecorder->IsRecording() && LeftHand && RightHand) RecordInputFrame(DeltaTime);
+}
+
+void AVirtualRealityPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (IsReplayingInput()) StopInputReplay(); // Time step is global, so it should not outlive PIE session or level
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AVirtualRealityPawn::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		InteractionTickFunction.Target = this;
+		InteractionTickFunction.RegisterTickFunction(GetLevel());
+	}
+	else if (InteractionTickFunction.IsTickFunctionRegistered())
+	{
+		InteractionTickFunction.UnRegisterTickFunction();
+	}
+}
+
 void AVirtualRealityPawn::Destroyed()
 {
+	if (IsReplayingInput()) StopInputReplay();
+	if (InputRecorder.IsValid())
+	{
+		InputRecorder->Close();
+		InputRecorder.Reset();
+	}
+
 	// Releasing resources that belong to current hands. TODO check maybe its released automatically when StreamableHandle gets destroyed
 	if (LeftHandStreamableHandle.IsValid())
 	{
@@ -79,16 +134,27 @@ void AVirtualRealityPawn::Destroyed()
 
 void AVirtualRealityPawn::OnStartTimerEnd()
 {
-	TSharedPtr<IXRTrackingSystem, ESPMode::ThreadSafe> TrackingSystem = GEngine->XRSystem;
-	if (!ensure(TrackingSystem.IsValid())) { return; }
+	if (IsReplayingInput())
+	{
+		// No headset is needed, controllers type comes from the record
+		TeleportToLocation(VRRootComponent->GetComponentLocation(), GetActorRotation());
+		StartInputReplay();
+	}
+	else
+	{
+		TSharedPtr<IXRTrackingSystem, ESPMode::ThreadSafe> TrackingSystem = GEngine->XRSystem;
+		if (!ensure(TrackingSystem.IsValid())) { return; }
 
-	TeleportToLocation(VRRootComponent->GetComponentLocation(), GetActorRotation()); // so player will be standing at spawn location even if he is not standing at the center of tracked zone irl
+		TeleportToLocation(VRRootComponent->GetComponentLocation(), GetActorRotation()); // so player will be standing at spawn location even if he is not standing at the center of tracked zone irl
 
-	// Check that VR Headset is present and set tracking origin
-	if (!InitHeadset(TrackingSystem.Get())) return;
-	
-	// Trying to create motion controlles using StartingControllerName if not none, or detecting Headset type using info from TrackingSystem
-	InitMotionControllers(TrackingSystem.Get());
+		// Check that VR Headset is present and set tracking origin
+		if (!InitHeadset(TrackingSystem.Get())) return;
+
+		// Trying to create motion controlles using StartingControllerName if not none, or detecting Headset type using info from TrackingSystem
+		InitMotionControllers(TrackingSystem.Get());
+
+		if (InputRecorder.IsValid() && !InputRecorder->OpenForRecording(CurrentControllersTypeName)) InputRecorder.Reset();
+	}
 
 	if (auto PlayerController = Cast<APlayerController>(GetController()))
 	{
@@ -141,6 +207,7 @@ bool AVirtualRealityPawn::SwitchMotionControllersByName(FName NewProfileName)
 		if (HeadsetType.HeadsetName.IsEqual(NewProfileName))
 		{
 			CurrentControllersTypeName = NewProfileName;
+			ApplyInputThresholds(HeadsetType.InputThresholds);
 			SwitchMotionControllersByClass(HeadsetType.LeftController, HeadsetType.RightController);
 
 			return true;
@@ -238,6 +305,10 @@ void AVirtualRealityPawn::CreateMotionController(bool bLeft, UClass* ClassToCrea
 	NewHandController->AttachToComponent(VRRootComponent, AttachmentRules);
 
 	NewHandController->InitialSetup(this, bLeft, !RightControllerIsPrimary);
+	NewHandController->AddTickPrerequisiteActor(this); // Pawn ticks after PlayerController processed input, so controllers may deliver whole frame of input in their Tick
+	NewHandController->SetPointingBatchedByPawn(bBatchHandsPointing);
+	if (NewHandController->IsPointingBatchedByPawn()) InteractionTickFunction.AddPrerequisite(NewHandController, NewHandController->PrimaryActorTick);
+	if (IsReplayingInput()) NewHandController->StartTrackingReplay();
 
 	if (bLeft) LeftHand = NewHandController;
 	else RightHand = NewHandController;
@@ -297,251 +368,335 @@ FTransform AVirtualRealityPawn::GetCameraWorldTransform() const
 
 // BEGIN INPUT
 
-void AVirtualRealityPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
+namespace VRPawnInputTable
 {
-	Super::SetupPlayerInputComponent(PlayerInputComponent);
+	// Some of the bindings exist only for controllers with capacitive sensors
+	enum class EBindingCondition : uint8 { Always, TriggerIsCapacitive, GripIsCapacitive };
 
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Right_Thumbstick_X, this, &AVirtualRealityPawn::Input_Axis_Right_Thumbstick_X);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Right_Thumbstick_Y, this, &AVirtualRealityPawn::Input_Axis_Right_Thumbstick_Y);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Left_Thumbstick_X, this, &AVirtualRealityPawn::Input_Axis_Left_Thumbstick_X);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Left_Thumbstick_Y, this, &AVirtualRealityPawn::Input_Axis_Left_Thumbstick_Y);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Right_Trigger, this, &AVirtualRealityPawn::Input_Axis_Right_Trigger);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Left_Trigger, this, &AVirtualRealityPawn::Input_Axis_Left_Trigger);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Right_Grip, this, &AVirtualRealityPawn::Input_Axis_Right_Grip);
-	PlayerInputComponent->BindAxis(InputBindingName_Axis_Left_Grip, this, &AVirtualRealityPawn::Input_Axis_Left_Grip);
-
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Primary_Press, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Primary, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Primary_Press, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Primary, EButtonActionType::ReleasedPress);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Secondary_Press, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Secondary, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Secondary_Press, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Secondary, EButtonActionType::ReleasedPress);
-	
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Primary_Press, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Primary, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Primary_Press, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Primary, EButtonActionType::ReleasedPress);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Secondary_Press, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Secondary, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Secondary_Press, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Secondary, EButtonActionType::ReleasedPress);
-	
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Primary_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Primary, EButtonActionType::Touched);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Primary_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Primary, EButtonActionType::ReleasedTouch);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Secondary_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Secondary, EButtonActionType::Touched);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Secondary_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Secondary, EButtonActionType::ReleasedTouch);
-	
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Primary_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Primary, EButtonActionType::Touched);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Primary_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Primary, EButtonActionType::ReleasedTouch);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Secondary_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Secondary, EButtonActionType::Touched);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Secondary_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Secondary, EButtonActionType::ReleasedTouch);
-
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Thumbstick_Press, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Thumbstick, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Thumbstick_Press, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Thumbstick, EButtonActionType::ReleasedPress);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Thumbstick_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Thumbstick, EButtonActionType::Touched);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Thumbstick_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Thumbstick, EButtonActionType::ReleasedTouch);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Thumbstick_Press, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Thumbstick, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Thumbstick_Press, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Thumbstick, EButtonActionType::ReleasedPress);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Thumbstick_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Thumbstick, EButtonActionType::Touched);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Thumbstick_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Thumbstick, EButtonActionType::ReleasedTouch);
-
-	if (bIsTriggerCapacitive)
-	{
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Trigger_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Trigger_Touch, EButtonActionType::Touched);
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Trigger_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Trigger_Touch, EButtonActionType::ReleasedTouch);
-		
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Trigger_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Trigger_Touch, EButtonActionType::Touched);
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Trigger_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Trigger_Touch, EButtonActionType::ReleasedTouch);
-	}
-
-	if (bIsGripCapacitive)
+	struct FAxisRow
 	{
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Grip_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Right_Grip_Touch, EButtonActionType::Touched);
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Right_Grip_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Right_Grip_Touch, EButtonActionType::ReleasedTouch);
-
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Grip_Touch, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Left_Grip_Touch, EButtonActionType::Touched);
-		PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Left_Grip_Touch, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Left_Grip_Touch, EButtonActionType::ReleasedTouch);
-	}
+		const TCHAR* AxisName;
+		EVRInputHand Hand;
+		EVRInputAxis Axis;
+	};
 
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Menu, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_Menu, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_Menu, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_Menu, EButtonActionType::ReleasedPress);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_System, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::Input_Button_System, EButtonActionType::Pressed);
-	PlayerInputComponent->BindAction<InputActionType>(InputBindingName_Button_Action_Button_System, EInputEvent::IE_Released, this, &AVirtualRealityPawn::Input_Button_System, EButtonActionType::ReleasedPress);
-}
-
-const FName AVirtualRealityPawn::InputBindingName_Axis_Right_Thumbstick_X("Axis_Right_Thumbstick_X");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Right_Thumbstick_Y("Axis_Right_Thumbstick_Y");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Left_Thumbstick_X("Axis_Left_Thumbstick_X");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Left_Thumbstick_Y("Axis_Left_Thumbstick_Y");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Right_Trigger("Axis_Right_Trigger");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Left_Trigger("Axis_Left_Trigger");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Right_Grip("Axis_Right_Grip");
-const FName AVirtualRealityPawn::InputBindingName_Axis_Left_Grip("Axis_Left_Grip");
-
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Primary_Press("Button_Left_Primary_Press");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Secondary_Press("Button_Left_Secondary_Press");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Primary_Press("Button_Right_Primary_Press");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Secondary_Press("Button_Right_Secondary_Press");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Primary_Touch("Button_Left_Primary_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Secondary_Touch("Button_Left_Secondary_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Primary_Touch("Button_Right_Primary_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Secondary_Touch("Button_Right_Secondary_Touch");
-
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Trigger_Touch("Button_Right_Trigger_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Trigger_Touch("Button_Left_Trigger_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Grip_Touch("Button_Right_Grip_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Grip_Touch("Button_Left_Grip_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Thumbstick_Touch("Button_Right_Thumbstick_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Thumbstick_Touch("Button_Left_Thumbstick_Touch");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Right_Thumbstick_Press("Button_Right_Thumbstick_Press");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Left_Thumbstick_Press("Button_Left_Thumbstick_Press");
-
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_Menu("Button_Menu");
-const FName AVirtualRealityPawn::InputBindingName_Button_Action_Button_System("Button_System");
-
-// Axies
-
-void AVirtualRealityPawn::Input_Axis_Right_Thumbstick_X(float Value) { if (RightHand) RightHand->PawnInput_Axis_Thumbstick_X(Value); }
-void AVirtualRealityPawn::Input_Axis_Right_Thumbstick_Y(float Value) { if (RightHand) RightHand->PawnInput_Axis_Thumbstick_Y(Value); }
-void AVirtualRealityPawn::Input_Axis_Left_Thumbstick_X(float Value) { if (LeftHand) LeftHand->PawnInput_Axis_Thumbstick_X(Value); }
-void AVirtualRealityPawn::Input_Axis_Left_Thumbstick_Y(float Value) { if (LeftHand) LeftHand->PawnInput_Axis_Thumbstick_Y(Value); }
-
-void AVirtualRealityPawn::Input_Axis_Right_Trigger(float Value)
-{
-	if (!RightHand) return;
-	
-	if (!bRightTriggerPressed && Value > AxisTriggerPressThreshold)
+	struct FActionRow
 	{
-		bRightTriggerPressed = true;
-		RightHand->PawnInput_Button_Trigger(EButtonActionType::Pressed);
-	}
-	else if (bRightTriggerPressed && Value < AxisTriggerPressThreshold)
+		const TCHAR* ActionName;
+		EVRInputHand Hand;
+		EVRInputButton Button;
+		EButtonActionType PressedType;
+		EButtonActionType ReleasedType;
+		EBindingCondition Condition;
+	};
+
+	// Names must match Project Settings -> Input
+	static const FAxisRow Axes[] =
 	{
-		bRightTriggerPressed = false;
-		RightHand->PawnInput_Button_Trigger(EButtonActionType::ReleasedPress);
-	}
-
-	if (!bIsTriggerCapacitive)
+		{ TEXT("Axis_Left_Thumbstick_X"),	EVRInputHand::Left,		EVRInputAxis::Thumbstick_X },
+		{ TEXT("Axis_Left_Thumbstick_Y"),	EVRInputHand::Left,		EVRInputAxis::Thumbstick_Y },
+		{ TEXT("Axis_Left_Trigger"),		EVRInputHand::Left,		EVRInputAxis::Trigger },
+		{ TEXT("Axis_Left_Grip"),			EVRInputHand::Left,		EVRInputAxis::Grip },
+		{ TEXT("Axis_Right_Thumbstick_X"),	EVRInputHand::Right,	EVRInputAxis::Thumbstick_X },
+		{ TEXT("Axis_Right_Thumbstick_Y"),	EVRInputHand::Right,	EVRInputAxis::Thumbstick_Y },
+		{ TEXT("Axis_Right_Trigger"),		EVRInputHand::Right,	EVRInputAxis::Trigger },
+		{ TEXT("Axis_Right_Grip"),			EVRInputHand::Right,	EVRInputAxis::Grip },
+	};
+
+	static const FActionRow Actions[] =
+	{
+		{ TEXT("Button_Left_Primary_Press"),		EVRInputHand::Left,		EVRInputButton::Primary,	EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_Left_Primary_Touch"),		EVRInputHand::Left,		EVRInputButton::Primary,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::Always },
+		{ TEXT("Button_Left_Secondary_Press"),		EVRInputHand::Left,		EVRInputButton::Secondary,	EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_Left_Secondary_Touch"),		EVRInputHand::Left,		EVRInputButton::Secondary,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::Always },
+		{ TEXT("Button_Left_Thumbstick_Press"),		EVRInputHand::Left,		EVRInputButton::Thumbstick,	EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_Left_Thumbstick_Touch"),		EVRInputHand::Left,		EVRInputButton::Thumbstick,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::Always },
+		{ TEXT("Button_Left_Trigger_Touch"),		EVRInputHand::Left,		EVRInputButton::Trigger,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::TriggerIsCapacitive },
+		{ TEXT("Button_Left_Grip_Touch"),			EVRInputHand::Left,		EVRInputButton::Grip,		EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::GripIsCapacitive },
+		{ TEXT("Button_Right_Primary_Press"),		EVRInputHand::Right,	EVRInputButton::Primary,	EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_Right_Primary_Touch"),		EVRInputHand::Right,	EVRInputButton::Primary,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::Always },
+		{ TEXT("Button_Right_Secondary_Press"),		EVRInputHand::Right,	EVRInputButton::Secondary,	EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_Right_Secondary_Touch"),		EVRInputHand::Right,	EVRInputButton::Secondary,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::Always },
+		{ TEXT("Button_Right_Thumbstick_Press"),	EVRInputHand::Right,	EVRInputButton::Thumbstick,	EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_Right_Thumbstick_Touch"),	EVRInputHand::Right,	EVRInputButton::Thumbstick,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::Always },
+		{ TEXT("Button_Right_Trigger_Touch"),		EVRInputHand::Right,	EVRInputButton::Trigger,	EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::TriggerIsCapacitive },
+		{ TEXT("Button_Right_Grip_Touch"),			EVRInputHand::Right,	EVRInputButton::Grip,		EButtonActionType::Touched, EButtonActionType::ReleasedTouch, EBindingCondition::GripIsCapacitive },
+		// these are not working for Oculus Rift S. Looks like steam VR and Oculus Home consumes those inputs. Maybe?
+		{ TEXT("Button_Menu"),						EVRInputHand::Left,		EVRInputButton::Menu,		EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+		{ TEXT("Button_System"),					EVRInputHand::Right,	EVRInputButton::System,		EButtonActionType::Pressed, EButtonActionType::ReleasedPress, EBindingCondition::Always },
+	};
+
+	// Press events of Trigger and Grip are not in the table, they are generated from axis values using thresholds
+	static bool TryGetAnalogButton(EVRInputAxis Axis, EVRAnalogButton& OutAnalogButton)
 	{
-		if (!bRightTriggerTouched && Value > AxisTriggerTouchThreshold)
+		switch (Axis)
 		{
-			bRightTriggerTouched = true;
-			RightHand->PawnInput_Button_Trigger(EButtonActionType::Touched);
+		case EVRInputAxis::Trigger: OutAnalogButton = EVRAnalogButton::Trigger; return true;
+		case EVRInputAxis::Grip: OutAnalogButton = EVRAnalogButton::Grip; return true;
+		default: return false;
 		}
-		else if (bRightTriggerTouched && Value < AxisTriggerTouchThreshold)
+	}
+
+	// Touch rows are always bound, current threshold profile decides if they are used
+	static bool IsConditionMet(EBindingCondition Condition, const FVRAnalogThresholdEngine& AnalogThresholds)
+	{
+		switch (Condition)
 		{
-			bRightTriggerTouched = false;
-			RightHand->PawnInput_Button_Trigger(EButtonActionType::ReleasedTouch);
+		case EBindingCondition::TriggerIsCapacitive: return AnalogThresholds.IsCapacitiveTouch(EVRAnalogButton::Trigger);
+		case EBindingCondition::GripIsCapacitive: return AnalogThresholds.IsCapacitiveTouch(EVRAnalogButton::Grip);
+		default: return true;
 		}
 	}
-
-	RightHand->PawnInput_Axis_Trigger(Value);
 }
 
-void AVirtualRealityPawn::Input_Axis_Left_Trigger(float Value)
+void AVirtualRealityPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
-	if (!LeftHand) return;
+	Super::SetupPlayerInputComponent(PlayerInputComponent);
+
+	if (FVRInputRecorder::IsReplayRequestedOnCommandLine()) return; // Replayed input only, connected devices should not interfere
+
+	static_assert(UE_ARRAY_COUNT(VRPawnInputTable::Axes) <= FVRInputRecorder::MaxRowsCount && UE_ARRAY_COUNT(VRPawnInputTable::Actions) <= FVRInputRecorder::MaxRowsCount, "Input recorder stores row index in 6 bits");
 
-	if (!bLeftTriggerPressed && Value > AxisTriggerPressThreshold)
+	for (int32 RowIndex = 0; RowIndex < UE_ARRAY_COUNT(VRPawnInputTable::Axes); ++RowIndex)
 	{
-		bLeftTriggerPressed = true;
-		LeftHand->PawnInput_Button_Trigger(EButtonActionType::Pressed);
+		FInputAxisBinding AxisBinding(VRPawnInputTable::Axes[RowIndex].AxisName);
+		AxisBinding.AxisDelegate.GetDelegateForManualSet().BindUObject(this, &AVirtualRealityPawn::DispatchInputAxis, RowIndex);
+		PlayerInputComponent->AxisBindings.Add(AxisBinding);
 	}
-	else if (bLeftTriggerPressed && Value < AxisTriggerPressThreshold)
+
+	for (int32 RowIndex = 0; RowIndex < UE_ARRAY_COUNT(VRPawnInputTable::Actions); ++RowIndex)
 	{
-		bLeftTriggerPressed = false;
-		LeftHand->PawnInput_Button_Trigger(EButtonActionType::ReleasedPress);
+		const VRPawnInputTable::FActionRow& Row = VRPawnInputTable::Actions[RowIndex];
+
+		PlayerInputComponent->BindAction<InputActionRowType>(Row.ActionName, EInputEvent::IE_Pressed, this, &AVirtualRealityPawn::DispatchInputAction, RowIndex, false);
+		PlayerInputComponent->BindAction<InputActionRowType>(Row.ActionName, EInputEvent::IE_Released, this, &AVirtualRealityPawn::DispatchInputAction, RowIndex, true);
 	}
+}
+
+AVirtualRealityMotionController* AVirtualRealityPawn::GetHandController(EVRInputHand Hand) const
+{
+	return Hand == EVRInputHand::Left ? LeftHand : RightHand;
+}
+
+void AVirtualRealityPawn::DispatchInputAxis(float Value, int32 RowIndex)
+{
+	if (InputRecorder.IsValid()) InputRecorder->RecordAxis(RowIndex, Value);
 
-	if (!bIsTriggerCapacitive)
+	const VRPawnInputTable::FAxisRow& Row = VRPawnInputTable::Axes[RowIndex];
+
+	EVRAnalogButton AnalogButton;
+	if (VRPawnInputTable::TryGetAnalogButton(Row.Axis, AnalogButton)) UpdateAnalogButton(Row.Hand, AnalogButton, Value, GetAnalogInputTime());
+
+	AVirtualRealityMotionController* HandController = GetHandController(Row.Hand);
+	if (!HandController) return;
+
+	HandController->PawnInput_Axis(Row.Axis, Value);
+}
+
+void AVirtualRealityPawn::DispatchInputAction(int32 RowIndex, bool bReleased)
+{
+	if (InputRecorder.IsValid()) InputRecorder->RecordAction(RowIndex, bReleased);
+
+	const VRPawnInputTable::FActionRow& Row = VRPawnInputTable::Actions[RowIndex];
+	if (!VRPawnInputTable::IsConditionMet(Row.Condition, AnalogThresholds)) return;
+
+	AVirtualRealityMotionController* HandController = GetHandController(Row.Hand);
+	if (!HandController) return;
+
+	HandController->PawnInput_Button(Row.Button, bReleased ? Row.ReleasedType : Row.PressedType);
+}
+
+void AVirtualRealityPawn::ApplyInputThresholds(const UVRInputThresholdProfile* Profile)
+{
+	if (Profile)
 	{
-		if (!bLeftTriggerTouched && Value > AxisTriggerTouchThreshold)
-		{
-			bLeftTriggerTouched = true;
-			LeftHand->PawnInput_Button_Trigger(EButtonActionType::Touched);
-		}
-		else if (bLeftTriggerTouched && Value < AxisTriggerTouchThreshold)
-		{
-			bLeftTriggerTouched = false;
-			LeftHand->PawnInput_Button_Trigger(EButtonActionType::ReleasedTouch);
-		}
+		AnalogThresholds.SetThresholds(EVRAnalogButton::Trigger, Profile->Trigger);
+		AnalogThresholds.SetThresholds(EVRAnalogButton::Grip, Profile->Grip);
+		return;
 	}
 
-	LeftHand->PawnInput_Axis_Trigger(Value);
+	FVRAnalogButtonThresholds Trigger;
+	Trigger.bCapacitiveTouch = bIsTriggerCapacitive;
+	Trigger.TouchEnter = Trigger.TouchExit = AxisTriggerTouchThreshold;
+	Trigger.PressEnter = Trigger.PressExit = AxisTriggerPressThreshold;
+	AnalogThresholds.SetThresholds(EVRAnalogButton::Trigger, Trigger);
+
+	FVRAnalogButtonThresholds Grip;
+	Grip.bCapacitiveTouch = bIsGripCapacitive;
+	Grip.TouchEnter = Grip.TouchExit = AxisGripTouchThreshold;
+	Grip.PressEnter = Grip.PressExit = AxisGripPressThreshold;
+	AnalogThresholds.SetThresholds(EVRAnalogButton::Grip, Grip);
 }
 
-void AVirtualRealityPawn::Input_Axis_Right_Grip(float Value)
+double AVirtualRealityPawn::GetAnalogInputTime() const
 {
-	if (!RightHand) return;
+	// World time, so replayed input debounces the same way
+	return GetWorld()->GetTimeSeconds();
+}
+
+void AVirtualRealityPawn::UpdateAnalogButton(EVRInputHand Hand, EVRAnalogButton AnalogButton, float Value, double Time)
+{
+	const int32 Channel = FVRAnalogThresholdEngine::ToChannel(Hand, AnalogButton);
+	SendAnalogButtonEvents(Channel, AnalogThresholds.SetValue(Channel, Value, Time));
+}
 
-	if (!bRightGripPressed && Value > AxisGripPressThreshold)
+void AVirtualRealityPawn::EvaluateAnalogButtons()
+{
+	const double Time = GetAnalogInputTime();
+	for (int32 Channel = 0; Channel < FVRAnalogThresholdEngine::NumChannels; ++Channel)
 	{
-		bRightGripPressed = true;
-		RightHand->PawnInput_Button_Grip(EButtonActionType::Pressed);
+		SendAnalogButtonEvents(Channel, AnalogThresholds.Evaluate(Channel, Time));
 	}
-	else if (bRightGripPressed && Value < AxisGripPressThreshold)
+}
+
+void AVirtualRealityPawn::SendAnalogButtonEvents(int32 Channel, uint8 Events)
+{
+	if (!Events) return;
+
+	AVirtualRealityMotionController* HandController = GetHandController(FVRAnalogThresholdEngine::GetChannelHand(Channel));
+	if (!HandController) return;
+
+	const EVRInputButton Button = VRInput::ToButton(FVRAnalogThresholdEngine::GetChannelAnalogButton(Channel));
+	for (uint8 ActionType = 0; Events; ++ActionType, Events >>= 1)
 	{
-		bRightGripPressed = false;
-		RightHand->PawnInput_Button_Grip(EButtonActionType::ReleasedPress);
+		if (Events & 1) HandController->PawnInput_Button(Button, static_cast<EButtonActionType>(ActionType));
 	}
+}
+
+// END INPUT
 
-	if (!bIsGripCapacitive)
+// BEGIN INPUT RECORDING
+
+bool AVirtualRealityPawn::IsReplayingInput() const
+{
+	return InputRecorder.IsValid() && InputRecorder->GetMode() == EVRInputRecorderMode::Replaying;
+}
+
+void AVirtualRealityPawn::StartInputReplay()
+{
+	FName RecordedControllersTypeName;
+	if (!InputRecorder->OpenForReplay(RecordedControllersTypeName))
 	{
-		if (!bRightGripTouched && Value > AxisGripTouchThreshold)
-		{
-			bRightGripTouched = true;
-			RightHand->PawnInput_Button_Grip(EButtonActionType::Touched);
-		}
-		else if (bRightGripTouched && Value < AxisGripTouchThreshold)
-		{
-			bRightGripTouched = false;
-			RightHand->PawnInput_Button_Grip(EButtonActionType::ReleasedTouch);
-		}
+		InputRecorder.Reset();
+		return;
 	}
 
-	RightHand->PawnInput_Axis_Grip(Value);
+	if (!SwitchMotionControllersByName(RecordedControllersTypeName) && !StartingControllerName.IsNone()) SwitchMotionControllersByName(StartingControllerName);
+
+	bUsedFixedTimeStepBeforeReplay = FApp::UseFixedTimeStep();
+	FixedDeltaTimeBeforeReplay = FApp::GetFixedDeltaTime();
+	bReplayTimeStepApplied = true;
+	ApplyReplayTimeStep();
 }
 
-void AVirtualRealityPawn::Input_Axis_Left_Grip(float Value)
+void AVirtualRealityPawn::StopInputReplay()
 {
-	if (!LeftHand) return;
+	InputRecorder->Close();
+	InputRecorder.Reset();
 
-	if (!bLeftGripPressed && Value > AxisGripPressThreshold)
+	if (bReplayTimeStepApplied)
 	{
-		bLeftGripPressed = true;
-		LeftHand->PawnInput_Button_Grip(EButtonActionType::Pressed);
+		FApp::SetUseFixedTimeStep(bUsedFixedTimeStepBeforeReplay);
+		FApp::SetFixedDeltaTime(FixedDeltaTimeBeforeReplay);
+		bReplayTimeStepApplied = false;
 	}
-	else if (bLeftGripPressed && Value < AxisGripPressThreshold)
+}
+
+void AVirtualRealityPawn::ApplyReplayTimeStep()
+{
+	// Engine reads it when next frame starts, so the frame that replays a record gets its recorded delta time
+	float NextDeltaTime = 0.f;
+	if (!InputRecorder->PeekDeltaTime(NextDeltaTime) || NextDeltaTime <= 0.f) return;
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(NextDeltaTime);
+}
+
+void AVirtualRealityPawn::RecordInputFrame(float DeltaTime)
+{
+	FVRInputRecordedPoses Poses;
+	Poses.HMD = MainCamera->GetRelativeTransform();
+	Poses.LeftController = LeftHand->GetTrackedRelativeTransform();
+	Poses.RightController = RightHand->GetTrackedRelativeTransform();
+
+	InputRecorder->EndFrame(DeltaTime, Poses);
+}
+
+void AVirtualRealityPawn::ReplayInputFrame()
+{
+	float RecordedDeltaTime = 0.f;
+	FVRInputRecordedPoses Poses;
+	TArray<FVRInputRecordedEvent> Events;
+
+	if (!InputRecorder->ReadFrame(RecordedDeltaTime, Poses, Events))
 	{
-		bLeftGripPressed = false;
-		LeftHand->PawnInput_Button_Grip(EButtonActionType::ReleasedPress);
+		StopInputReplay();
+
+		if (FParse::Param(FCommandLine::Get(), TEXT("VRInputReplayQuit"))) FPlatformMisc::RequestExit(false);
+		return;
 	}
 
-	if (!bIsGripCapacitive)
+	// Poses first so controllers and states see this frame`s transforms together with its input
+	MainCamera->SetRelativeTransform(Poses.HMD);
+	LeftHand->SetReplayedTrackedTransform(Poses.LeftController);
+	RightHand->SetReplayedTrackedTransform(Poses.RightController);
+
+	for (const FVRInputRecordedEvent& Event : Events)
 	{
-		if (!bLeftGripTouched && Value > AxisGripTouchThreshold)
+		if (Event.bAction)
 		{
-			bLeftGripTouched = true;
-			LeftHand->PawnInput_Button_Grip(EButtonActionType::Touched);
-		}
-		else if (bLeftGripTouched && Value < AxisGripTouchThreshold)
-		{
-			bLeftGripTouched = false;
-			LeftHand->PawnInput_Button_Grip(EButtonActionType::ReleasedTouch);
+			if (Event.RowIndex < UE_ARRAY_COUNT(VRPawnInputTable::Actions)) DispatchInputAction(Event.RowIndex, Event.bReleased);
 		}
+		else if (Event.RowIndex < UE_ARRAY_COUNT(VRPawnInputTable::Axes)) DispatchInputAxis(Event.Value, Event.RowIndex);
 	}
 
-	LeftHand->PawnInput_Axis_Grip(Value);
+	ApplyReplayTimeStep();
+}
+
+// Interaction of both hands
+
+void FVRPawnInteractionTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKillOrUnreachable() && TickType != LEVELTICK_ViewportsOnly) Target->TickInteraction(DeltaTime);
+}
+
+FString FVRPawnInteractionTickFunction::DiagnosticMessage()
+{
+	return Target ? Target->GetFullName() + TEXT("[TickInteraction]") : TEXT("<none>[TickInteraction]");
 }
 
-// Buttons
+void AVirtualRealityPawn::TickInteraction(float DeltaTime)
+{
+	if (!bBatchHandsPointing) return;
+
+	struct FPointingJob
+	{
+		AVirtualRealityMotionController* Controller = nullptr;
+		FVector Start;
+		FVector End;
+		FHitResult HitResult;
+		bool bHit = false;
+	};
+	TArray<FPointingJob, TInlineAllocator<2>> Jobs;
+
+	for (AVirtualRealityMotionController* Hand : { LeftHand, RightHand })
+	{
+		if (!Hand || Hand->IsPendingKill() || !Hand->IsPointingBatchedByPawn()) continue;
 
-void AVirtualRealityPawn::Input_Button_Left_Primary(EButtonActionType EventType) { if (LeftHand) LeftHand->PawnInput_Button_Primary(EventType); }
-void AVirtualRealityPawn::Input_Button_Left_Secondary(EButtonActionType EventType) { if (LeftHand) LeftHand->PawnInput_Button_Secondary(EventType); }
-void AVirtualRealityPawn::Input_Button_Right_Primary(EButtonActionType EventType) { if (RightHand) RightHand->PawnInput_Button_Primary(EventType); }
-void AVirtualRealityPawn::Input_Button_Right_Secondary(EButtonActionType EventType) { if (RightHand) RightHand->PawnInput_Button_Secondary(EventType); }
+		FPointingJob& Job = Jobs.AddDefaulted_GetRef();
+		Job.Controller = Hand;
+		if (!Hand->PreparePointingTrace(Job.Start, Job.End)) Jobs.Pop(false); // Result is already applied
+	}
 
-void AVirtualRealityPawn::Input_Button_Right_Trigger_Touch(EButtonActionType EventType) { if (RightHand) RightHand->PawnInput_Button_Trigger(EventType); }
-void AVirtualRealityPawn::Input_Button_Left_Trigger_Touch(EButtonActionType EventType) { if (LeftHand) LeftHand->PawnInput_Button_Trigger(EventType); }
-void AVirtualRealityPawn::Input_Button_Right_Grip_Touch(EButtonActionType EventType) { if (RightHand) RightHand->PawnInput_Button_Grip(EventType); }
-void AVirtualRealityPawn::Input_Button_Left_Grip_Touch(EButtonActionType EventType) { if (LeftHand) LeftHand->PawnInput_Button_Grip(EventType); }
+	if (Jobs.Num() == 0) return;
 
-void AVirtualRealityPawn::Input_Button_Left_Thumbstick(EButtonActionType EventType) { if (LeftHand) LeftHand->PawnInput_Button_Thumbstick(EventType); }
-void AVirtualRealityPawn::Input_Button_Right_Thumbstick(EButtonActionType EventType) { if (RightHand) RightHand->PawnInput_Button_Thumbstick(EventType); }
+	// Scene queries only read physics scene, game thread takes one of them and waits for the other
+	ParallelFor(Jobs.Num(), [&Jobs](int32 Index)
+	{
+		FPointingJob& Job = Jobs[Index];
+		Job.bHit = Job.Controller->TracePointing(Job.Start, Job.End, Job.HitResult);
+	}, Jobs.Num() < 2);
 
-void AVirtualRealityPawn::Input_Button_Menu(EButtonActionType EventType) { if (LeftHand) LeftHand->PawnInput_Button_Menu(EventType); }
-void AVirtualRealityPawn::Input_Button_System(EButtonActionType EventType) { if (RightHand) RightHand->PawnInput_Button_System(EventType); }
\ No newline at end of file
+	// Interface events are sent on game thread only, after both traces are done
+	for (FPointingJob& Job : Jobs) Job.Controller->FinishPointingTrace(Job.Start, Job.End, Job.bHit ? &Job.HitResult : nullptr);
+}
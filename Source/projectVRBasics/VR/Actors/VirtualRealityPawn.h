@@ -4,8 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "Engine/EngineBaseTypes.h"
 
 #include "Interfaces/VRPlayerInput.h"
+#include "../Input/VRInputTypes.h"
+#include "../Input/VRAnalogThresholdEngine.h"
 
 #include "VirtualRealityPawn.generated.h"
 
@@ -13,10 +16,13 @@ class UCameraComponent;
 class IXRTrackingSystem;
 class UCapsuleComponent;
 class AVirtualRealityMotionController;
+class AVirtualRealityPawn;
+class FVRInputRecorder;
+class UVRInputThresholdProfile;
 
 struct FStreamableHandle;
 
-DECLARE_DELEGATE_OneParam(InputActionType, EButtonActionType);
+DECLARE_DELEGATE_TwoParams(InputActionRowType, int32, bool); // Row index in input binding table and if that was a release event
 
 USTRUCT(Blueprintable)
 struct FControllerType
@@ -30,6 +36,26 @@ public:
 	TSoftClassPtr<AVirtualRealityMotionController> LeftController;
 	UPROPERTY(EditAnywhere)
 	TSoftClassPtr<AVirtualRealityMotionController> RightController;
+	UPROPERTY(EditAnywhere) // Trigger and Grip settings of this headset. If empty, pawn`s VR Input Setup values are used
+	UVRInputThresholdProfile* InputThresholds = nullptr;
+};
+
+// Pawn`s second tick, runs after both motion controllers ticked so interaction of both hands is evaluated on the same poses and states (see AVirtualRealityPawn::TickInteraction)
+USTRUCT()
+struct FVRPawnInteractionTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	AVirtualRealityPawn* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FVRPawnInteractionTickFunction> : public TStructOpsTypeTraitsBase2<FVRPawnInteractionTickFunction>
+{
+	enum { WithCopy = false };
 };
 
 UCLASS()
@@ -43,6 +69,9 @@ public:
 protected:
 
 	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
 	virtual void Destroyed() override;
 	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
 
@@ -113,77 +142,52 @@ private:
 	TSharedPtr<FStreamableHandle> LeftHandStreamableHandle;
 	TSharedPtr<FStreamableHandle> RightHandStreamableHandle;
 
+	// Input recording and replay, created only if requested on command line (see FVRInputRecorder)
+	TSharedPtr<FVRInputRecorder> InputRecorder;
+
+	bool IsReplayingInput() const;
+	void StartInputReplay();
+	void StopInputReplay();
+	void RecordInputFrame(float DeltaTime);
+	void ReplayInputFrame();
+	// Next frame uses delta time it was recorded with
+	void ApplyReplayTimeStep();
+
+	// Fixed time step settings before replay, restored when it stops
+	bool bUsedFixedTimeStepBeforeReplay = false;
+	double FixedDeltaTimeBeforeReplay = 0.0;
+	bool bReplayTimeStepApplied = false;
+
 	// Input bindings
 	// Binding Input one time so controller states and objects that were grabbed by hand should not receive any input themselves and just implement IVRPlayerInputInterface BP events.
-	// Input gets received by a Pawn, then Pawn calls Interface functions on Virtual Reality Motion Controller class. Then VRMotionController may forward them to states and grabbed objects.
+	// Input gets received by a Pawn, then Pawn forwards it to Virtual Reality Motion Controller class. Then VRMotionController may forward them to states and grabbed objects.
 
-	// Downside of this implementation is there is a lot of boilerplate code
-	// But upsides are:
+	// Every ue4 Axis and Action that we are interested in is a row in a static table (see VirtualRealityPawn.cpp) keyed by hand, control and event type.
+	// All bindings are generated from that table and every event goes through one of two dispatchers below with row index as a payload, so adding a control is one more table row
+	// Upsides are:
 	// - Only 10 nodes in BPs: 3 axies and 7 button actions (because left hand state has no need to know about right hand input and so on). Full controll on what button was pressed/touched/released
 	// - Changing ue4 Input Settings will not affect any BPs
 	// - Custom thresholds for Touch and Press Events (currently for Trigger and Grip buttons)
 	// As the result ue4 input is completely detached from any logic in BP regarding input
 
 	protected:
-		static const FName InputBindingName_Axis_Right_Thumbstick_X;
-		static const FName InputBindingName_Axis_Right_Thumbstick_Y;
-		static const FName InputBindingName_Axis_Left_Thumbstick_X;
-		static const FName InputBindingName_Axis_Left_Thumbstick_Y;
-		static const FName InputBindingName_Axis_Right_Trigger;
-		static const FName InputBindingName_Axis_Left_Trigger;
-		static const FName InputBindingName_Axis_Right_Grip;
-		static const FName InputBindingName_Axis_Left_Grip;
-
-		static const FName InputBindingName_Button_Action_Button_Left_Primary_Press;
-		static const FName InputBindingName_Button_Action_Button_Left_Secondary_Press;
-		static const FName InputBindingName_Button_Action_Button_Right_Primary_Press;
-		static const FName InputBindingName_Button_Action_Button_Right_Secondary_Press;
-		static const FName InputBindingName_Button_Action_Button_Left_Primary_Touch;
-		static const FName InputBindingName_Button_Action_Button_Left_Secondary_Touch;
-		static const FName InputBindingName_Button_Action_Button_Right_Primary_Touch;
-		static const FName InputBindingName_Button_Action_Button_Right_Secondary_Touch;
-		static const FName InputBindingName_Button_Action_Button_Right_Trigger_Touch;
-		static const FName InputBindingName_Button_Action_Button_Left_Trigger_Touch;
-		//static const FName InputBindingName_Button_Action_Button_Right_Trigger_Press;
-		//static const FName InputBindingName_Button_Action_Button_Left_Trigger_Press;
-		static const FName InputBindingName_Button_Action_Button_Right_Grip_Touch;
-		static const FName InputBindingName_Button_Action_Button_Left_Grip_Touch;
-		//static const FName InputBindingName_Button_Action_Button_Right_Grip_Press;
-		//static const FName InputBindingName_Button_Action_Button_Left_Grip_Press;
-		static const FName InputBindingName_Button_Action_Button_Right_Thumbstick_Touch;
-		static const FName InputBindingName_Button_Action_Button_Left_Thumbstick_Touch;
-		static const FName InputBindingName_Button_Action_Button_Right_Thumbstick_Press;
-		static const FName InputBindingName_Button_Action_Button_Left_Thumbstick_Press;
-		static const FName InputBindingName_Button_Action_Button_Menu;
-		static const FName InputBindingName_Button_Action_Button_System;
-
-		UFUNCTION() void Input_Axis_Right_Thumbstick_X(float Value);
-		UFUNCTION() void Input_Axis_Right_Thumbstick_Y(float Value);
-		UFUNCTION() void Input_Axis_Left_Thumbstick_X(float Value);
-		UFUNCTION() void Input_Axis_Left_Thumbstick_Y(float Value);
-		UFUNCTION() void Input_Axis_Right_Trigger(float Value);
-		UFUNCTION() void Input_Axis_Left_Trigger(float Value);
-		UFUNCTION() void Input_Axis_Right_Grip(float Value);
-		UFUNCTION() void Input_Axis_Left_Grip(float Value);
-
-		UFUNCTION() void Input_Button_Left_Primary(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Left_Secondary(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Right_Primary(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Right_Secondary(EButtonActionType EventType);
-
-		UFUNCTION() void Input_Button_Right_Trigger_Touch(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Left_Trigger_Touch(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Right_Grip_Touch(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Left_Grip_Touch(EButtonActionType EventType);
-
-		UFUNCTION() void Input_Button_Left_Thumbstick(EButtonActionType EventType);
-		UFUNCTION() void Input_Button_Right_Thumbstick(EButtonActionType EventType);
-
-		UFUNCTION() void Input_Button_Menu(EButtonActionType EventType); // these and System_Press are not working for Oculus Rift S. Looks like steam VR and Oculus Home consumes those inputs. Maybe?
-		UFUNCTION() void Input_Button_System(EButtonActionType EventType);
+		void DispatchInputAxis(float Value, int32 RowIndex);
+		void DispatchInputAction(int32 RowIndex, bool bReleased);
+
+		// Touch and Press events of analog Trigger and Grip are generated by AnalogThresholds
+		void UpdateAnalogButton(EVRInputHand Hand, EVRAnalogButton AnalogButton, float Value, double Time);
+		void EvaluateAnalogButtons();
+		void SendAnalogButtonEvents(int32 Channel, uint8 Events);
+		double GetAnalogInputTime() const;
+
+		// nullptr to use values below
+		void ApplyInputThresholds(const UVRInputThresholdProfile* Profile);
+
+		AVirtualRealityMotionController* GetHandController(EVRInputHand Hand) const;
 
+		// Used if current controller type has no UVRInputThresholdProfile. Enter and Exit thresholds are the same
 		UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VR Input Setup")
-		bool bIsTriggerCapacitive = true; // TODO make false and create custom settings for every headset. Maybe move this to controller class
+		bool bIsTriggerCapacitive = true;
 		UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VR Input Setup")
 		bool bIsGripCapacitive = false;
 		UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VR Input Setup", meta = (EditCondition = "!bIsTriggerCapacitive"))
@@ -195,13 +199,18 @@ private:
 		UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VR Input Setup")
 		float AxisGripPressThreshold = 0.95f;
 	private:
-		bool bRightTriggerPressed = false;
-		bool bRightTriggerTouched = false;
-		bool bRightGripPressed = false;
-		bool bRightGripTouched = false;
-
-		bool bLeftTriggerPressed = false;
-		bool bLeftTriggerTouched = false;
-		bool bLeftGripPressed = false;
-		bool bLeftGripTouched = false;
+		FVRAnalogThresholdEngine AnalogThresholds;
+
+	// Interaction of both hands
+	protected:
+		// Pointing rays of both controllers are traced in parallel after both of them ticked and results are applied in one pass, so both hands see the same hit state within a frame.
+		// If disabled, every controller traces in its own Tick. Controllers with bAsyncPointingTrace always do
+		UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "VR Setup")
+		bool bBatchHandsPointing = false;
+
+		void TickInteraction(float DeltaTime);
+	private:
+		friend struct FVRPawnInteractionTickFunction;
+
+		FVRPawnInteractionTickFunction InteractionTickFunction;
 };
@@ -0,0 +1,71 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRAnalogThresholdEngine.h"
+
+#include "VRInputThresholdProfile.h"
+
+
+void FVRAnalogThresholdEngine::SetThresholds(EVRAnalogButton AnalogButton, const FVRAnalogButtonThresholds& Thresholds)
+{
+	FChannelSettings& ChannelSettings = Settings[VRInput::ToIndex(AnalogButton)];
+	ChannelSettings.bCapacitiveTouch = Thresholds.bCapacitiveTouch;
+	ChannelSettings.TouchEnter = Thresholds.TouchEnter;
+	ChannelSettings.TouchExit = FMath::Min(Thresholds.TouchExit, Thresholds.TouchEnter); // Exit above Enter would make button flip every evaluation
+	ChannelSettings.PressEnter = Thresholds.PressEnter;
+	ChannelSettings.PressExit = FMath::Min(Thresholds.PressExit, Thresholds.PressEnter);
+	ChannelSettings.DebounceTime = Thresholds.DebounceTime;
+
+	// States are reset without sending release events, controllers are recreated when thresholds change
+	for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+	{
+		if (GetChannelAnalogButton(Channel) == AnalogButton) States[Channel] = FChannelState();
+	}
+}
+
+bool FVRAnalogThresholdEngine::IsCapacitiveTouch(EVRAnalogButton AnalogButton) const
+{
+	return Settings[VRInput::ToIndex(AnalogButton)].bCapacitiveTouch;
+}
+
+uint8 FVRAnalogThresholdEngine::SetValue(int32 Channel, float Value, double Time)
+{
+	States[Channel].Value = Value;
+	return Evaluate(Channel, Time);
+}
+
+uint8 FVRAnalogThresholdEngine::Evaluate(int32 Channel, double Time)
+{
+	const FChannelSettings& ChannelSettings = Settings[VRInput::ToIndex(GetChannelAnalogButton(Channel))];
+	FChannelState& State = States[Channel];
+	uint8 Events = 0;
+
+	if (!ChannelSettings.bCapacitiveTouch && UpdateHysteresis(State.bTouched, State.TouchChangeStartTime, State.Value, ChannelSettings.TouchEnter, ChannelSettings.TouchExit, ChannelSettings.DebounceTime, Time))
+	{
+		Events |= EventBit(State.bTouched ? EButtonActionType::Touched : EButtonActionType::ReleasedTouch);
+	}
+	if (UpdateHysteresis(State.bPressed, State.PressChangeStartTime, State.Value, ChannelSettings.PressEnter, ChannelSettings.PressExit, ChannelSettings.DebounceTime, Time))
+	{
+		Events |= EventBit(State.bPressed ? EButtonActionType::Pressed : EButtonActionType::ReleasedPress);
+	}
+
+	return Events;
+}
+
+bool FVRAnalogThresholdEngine::UpdateHysteresis(bool& bState, double& ChangeStartTime, float Value, float Enter, float Exit, float DebounceTime, double Time)
+{
+	const bool bWantedState = bState ? Value >= Exit : Value > Enter;
+
+	if (bWantedState == bState)
+	{
+		ChangeStartTime = -1.0; // Value went back before debounce ended
+		return false;
+	}
+
+	if (ChangeStartTime < 0.0) ChangeStartTime = Time;
+	if (Time - ChangeStartTime < DebounceTime) return false;
+
+	bState = bWantedState;
+	ChangeStartTime = -1.0;
+	return true;
+}
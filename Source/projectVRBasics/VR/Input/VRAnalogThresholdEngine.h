@@ -0,0 +1,61 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRInputTypes.h"
+
+struct FVRAnalogButtonThresholds;
+
+/**
+ * Generates Touch and Press events of analog Trigger and Grip for both hands. Every hand and analog button pair is a channel with the same evaluation code, settings come from UVRInputThresholdProfile.
+ * Pawn feeds values as they arrive and evaluates every channel once per frame so debounce can finish even if value stops changing
+ */
+class PROJECTVRBASICS_API FVRAnalogThresholdEngine
+{
+public:
+	static constexpr int32 NumChannels = VRInput::NumHands * VRInput::NumAnalogButtons;
+
+	static FORCEINLINE int32 ToChannel(EVRInputHand Hand, EVRAnalogButton AnalogButton) { return VRInput::ToIndex(Hand) * VRInput::NumAnalogButtons + VRInput::ToIndex(AnalogButton); }
+	static FORCEINLINE EVRInputHand GetChannelHand(int32 Channel) { return static_cast<EVRInputHand>(Channel / VRInput::NumAnalogButtons); }
+	static FORCEINLINE EVRAnalogButton GetChannelAnalogButton(int32 Channel) { return static_cast<EVRAnalogButton>(Channel % VRInput::NumAnalogButtons); }
+
+	// Bit per EButtonActionType. Iterating bits from lowest gives Touched, Pressed, ReleasedPress, ReleasedTouch which is the order events should be sent in
+	static FORCEINLINE uint8 EventBit(EButtonActionType ActionType) { return 1 << static_cast<uint8>(ActionType); }
+
+	// Same thresholds for both hands. Resets state of every channel
+	void SetThresholds(EVRAnalogButton AnalogButton, const FVRAnalogButtonThresholds& Thresholds);
+	bool IsCapacitiveTouch(EVRAnalogButton AnalogButton) const;
+
+	// Stores new value and evaluates that channel. Returns EventBit() mask of events that should be sent
+	uint8 SetValue(int32 Channel, float Value, double Time);
+	// Evaluates channel using its last value
+	uint8 Evaluate(int32 Channel, double Time);
+
+private:
+	struct FChannelSettings
+	{
+		float TouchEnter = 0.f;
+		float TouchExit = 0.f;
+		float PressEnter = 0.f;
+		float PressExit = 0.f;
+		float DebounceTime = 0.f;
+		bool bCapacitiveTouch = false;
+	};
+
+	struct FChannelState
+	{
+		float Value = 0.f;
+		bool bTouched = false;
+		bool bPressed = false;
+		double TouchChangeStartTime = -1.0; // when value crossed touch threshold, while waiting for debounce
+		double PressChangeStartTime = -1.0;
+	};
+
+	// Returns true if state flipped
+	static bool UpdateHysteresis(bool& bState, double& ChangeStartTime, float Value, float Enter, float Exit, float DebounceTime, double Time);
+
+	FChannelSettings Settings[VRInput::NumAnalogButtons];
+	FChannelState States[NumChannels];
+};
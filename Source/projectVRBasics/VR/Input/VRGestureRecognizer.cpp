@@ -0,0 +1,112 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRGestureRecognizer.h"
+
+#include "VRInputHistory.h"
+
+
+void FVRGestureRecognizer::Reset()
+{
+	LastCenteredTime = -1.0;
+	bFlickArmed = false;
+
+	for (double& PressTime : LastPressTimes) PressTime = -1.0;
+
+	LastShakeDirection = FVector::ZeroVector;
+	LastShakeMoveTime = -1.0;
+	FirstReversalTime = -1.0;
+	ReversalsCount = 0;
+}
+
+void FVRGestureRecognizer::Update(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents)
+{
+	if (History.Num() == 0) return;
+
+	if (Settings.bDetectThumbstickFlick) UpdateFlick(History, Settings, OutEvents);
+	if (Settings.bDetectDoubleTap) UpdateDoubleTap(History, Settings, OutEvents);
+	if (Settings.bDetectShake) UpdateShake(History, Settings, OutEvents);
+}
+
+void FVRGestureRecognizer::UpdateFlick(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents)
+{
+	const FVRInputHistorySample& Sample = History.GetLatest();
+	const float SquaredRadius = Sample.Thumbstick.SizeSquared();
+
+	if (SquaredRadius <= FMath::Square(Settings.FlickCenterRadius))
+	{
+		LastCenteredTime = Sample.Time;
+		bFlickArmed = true;
+	}
+	else if (bFlickArmed && SquaredRadius >= FMath::Square(Settings.FlickEdgeRadius))
+	{
+		bFlickArmed = false; // Too slow movement is not a flick and is not retried until thumbstick is centered again
+		if (Sample.Time - LastCenteredTime > Settings.FlickMaxTime) return;
+
+		FVRGestureEvent& Event = OutEvents.AddDefaulted_GetRef();
+		Event.Gesture = EVRGesture::ThumbstickFlick;
+		Event.FlickDirection = Sample.Thumbstick.GetSafeNormal();
+	}
+}
+
+void FVRGestureRecognizer::UpdateDoubleTap(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents)
+{
+	const FVRInputHistorySample& Sample = History.GetLatest();
+	if (!Sample.PressedEventsMask) return;
+
+	for (int32 ButtonIndex = 0; ButtonIndex < VRInput::NumButtons; ++ButtonIndex)
+	{
+		if (!(Sample.PressedEventsMask & (1 << ButtonIndex))) continue;
+
+		double& LastPressTime = LastPressTimes[ButtonIndex];
+		if (LastPressTime >= 0.0 && Sample.Time - LastPressTime <= Settings.DoubleTapMaxInterval)
+		{
+			LastPressTime = -1.0; // Third press starts a new double tap
+			FVRGestureEvent& Event = OutEvents.AddDefaulted_GetRef();
+			Event.Gesture = EVRGesture::DoubleTap;
+			Event.Button = static_cast<EVRInputButton>(ButtonIndex);
+		}
+		else LastPressTime = Sample.Time;
+	}
+}
+
+void FVRGestureRecognizer::UpdateShake(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents)
+{
+	if (History.Num() < 2) return;
+
+	const FVRInputHistorySample& Sample = History.GetLatest();
+	const FVRInputHistorySample& PreviousSample = History.GetFromLatest(1);
+
+	const double DeltaTime = Sample.Time - PreviousSample.Time;
+	if (DeltaTime <= 0.0) return;
+
+	const FVector Velocity = (Sample.Location - PreviousSample.Location) / DeltaTime;
+	if (Velocity.SizeSquared() < FMath::Square(Settings.ShakeMinSpeed)) return;
+
+	if (Sample.Time - LastShakeMoveTime > Settings.ShakeMaxTime)
+	{
+		// Hand was still, so earlier movement is not a part of this shake
+		LastShakeDirection = FVector::ZeroVector;
+		ReversalsCount = 0;
+	}
+	LastShakeMoveTime = Sample.Time;
+
+	const FVector Direction = Velocity.GetUnsafeNormal();
+	const bool bReversed = !LastShakeDirection.IsZero() && FVector::DotProduct(Direction, LastShakeDirection) < -0.5f;
+	LastShakeDirection = Direction;
+
+	if (!bReversed) return;
+
+	if (ReversalsCount == 0 || Sample.Time - FirstReversalTime > Settings.ShakeMaxTime)
+	{
+		FirstReversalTime = Sample.Time;
+		ReversalsCount = 1;
+	}
+	else ++ReversalsCount;
+
+	if (ReversalsCount < Settings.ShakeReversals) return;
+
+	ReversalsCount = 0;
+	FVRGestureEvent& Event = OutEvents.AddDefaulted_GetRef();
+	Event.Gesture = EVRGesture::Shake;
+}
@@ -0,0 +1,97 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRInputTypes.h"
+
+#include "VRGestureRecognizer.generated.h"
+
+class FVRInputHistory;
+
+UENUM(BlueprintType)
+enum class EVRGesture : uint8 {
+	ThumbstickFlick = 0 UMETA(DisplayName = "Thumbstick Flick"),
+	DoubleTap = 1 UMETA(DisplayName = "Double Tap"),
+	Shake = 2 UMETA(DisplayName = "Shake")
+};
+
+USTRUCT(BlueprintType)
+struct PROJECTVRBASICS_API FVRGestureEvent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "VR Gesture")
+	EVRGesture Gesture = EVRGesture::ThumbstickFlick;
+	UPROPERTY(BlueprintReadOnly, Category = "VR Gesture")
+	FVector2D FlickDirection = FVector2D::ZeroVector; // ThumbstickFlick only, normalized
+	UPROPERTY(BlueprintReadOnly, Category = "VR Gesture")
+	EVRInputButton Button = EVRInputButton::Primary; // DoubleTap only
+};
+
+USTRUCT(BlueprintType)
+struct PROJECTVRBASICS_API FVRGestureSettings
+{
+	GENERATED_BODY()
+
+public:
+	// Thumbstick goes from center to the edge faster than FlickMaxTime
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture")
+	bool bDetectThumbstickFlick = false;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectThumbstickFlick"))
+	float FlickCenterRadius = 0.3f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectThumbstickFlick"))
+	float FlickEdgeRadius = 0.85f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectThumbstickFlick", Units = "s"))
+	float FlickMaxTime = 0.12f;
+
+	// Two presses of the same button
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture")
+	bool bDetectDoubleTap = false;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectDoubleTap", Units = "s"))
+	float DoubleTapMaxInterval = 0.3f;
+
+	// Hand quickly changes its movement direction several times
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture")
+	bool bDetectShake = false;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectShake", Units = "cm/s"))
+	float ShakeMinSpeed = 120.f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectShake"))
+	int32 ShakeReversals = 4;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Gesture", meta = (EditCondition = "bDetectShake", Units = "s"))
+	float ShakeMaxTime = 0.8f;
+
+	bool IsAnyGestureEnabled() const { return bDetectThumbstickFlick || bDetectDoubleTap || bDetectShake; }
+};
+
+/**
+ * Native recognizers of one hand. Updated once per motion controller Tick after the latest history sample was added, every recognizer keeps its own small state so only the newest samples are looked at
+ */
+class PROJECTVRBASICS_API FVRGestureRecognizer
+{
+public:
+	FVRGestureRecognizer() { Reset(); }
+
+	void Update(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents);
+	void Reset();
+
+private:
+	void UpdateFlick(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents);
+	void UpdateDoubleTap(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents);
+	void UpdateShake(const FVRInputHistory& History, const FVRGestureSettings& Settings, TArray<FVRGestureEvent, TInlineAllocator<4>>& OutEvents);
+
+	// Flick
+	double LastCenteredTime;
+	bool bFlickArmed; // Thumbstick must return to center before next flick
+
+	// Double Tap
+	double LastPressTimes[VRInput::NumButtons];
+
+	// Shake
+	FVector LastShakeDirection;
+	double LastShakeMoveTime; // Direction is forgotten after ShakeMaxTime without fast movement
+	double FirstReversalTime;
+	int32 ReversalsCount;
+};
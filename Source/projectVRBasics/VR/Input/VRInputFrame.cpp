@@ -0,0 +1,70 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInputFrame.h"
+
+
+float FVRInputFrame::GetAxis(EVRInputAxis Axis) const
+{
+	switch (Axis)
+	{
+	case EVRInputAxis::Thumbstick_X: return Thumbstick_X;
+	case EVRInputAxis::Thumbstick_Y: return Thumbstick_Y;
+	case EVRInputAxis::Trigger: return Trigger;
+	case EVRInputAxis::Grip: return Grip;
+	default: return 0.f;
+	}
+}
+
+bool FVRInputFrame::SetAxis(EVRInputAxis Axis, float Value)
+{
+	float* AxisValue = nullptr;
+	switch (Axis)
+	{
+	case EVRInputAxis::Thumbstick_X: AxisValue = &Thumbstick_X; break;
+	case EVRInputAxis::Thumbstick_Y: AxisValue = &Thumbstick_Y; break;
+	case EVRInputAxis::Trigger: AxisValue = &Trigger; break;
+	case EVRInputAxis::Grip: AxisValue = &Grip; break;
+	default: return false;
+	}
+
+	if (*AxisValue == Value) return false;
+
+	*AxisValue = Value;
+	ChangedMask |= static_cast<int32>(VRInput::AxisBit(Axis));
+	return true;
+}
+
+void FVRInputFrame::AddButtonEvent(EVRInputButton Button, EButtonActionType ActionType)
+{
+	ButtonEventsMask |= static_cast<int32>(ButtonEventBit(Button, ActionType));
+	ChangedMask |= static_cast<int32>(VRInput::ButtonBit(Button));
+
+	const int32 PressedBit = 1 << VRInput::ToIndex(Button);
+	const int32 TouchedBit = 1 << (VRInput::TouchedButtonsShift + VRInput::ToIndex(Button));
+
+	switch (ActionType)
+	{
+	case EButtonActionType::Pressed: ButtonStateMask |= PressedBit; break;
+	case EButtonActionType::ReleasedPress: ButtonStateMask &= ~PressedBit; break;
+	case EButtonActionType::Touched: ButtonStateMask |= TouchedBit; break;
+	case EButtonActionType::ReleasedTouch: ButtonStateMask &= ~TouchedBit; break;
+	}
+}
+
+void FVRInputFrame::ClearControls(uint32 ControlsMask)
+{
+	ChangedMask &= ~static_cast<int32>(ControlsMask);
+
+	// Same button bits repeated for every EButtonActionType
+	const uint32 Buttons = (ControlsMask & VRInput::AllButtonsMask) >> VRInput::ButtonBitsShift;
+	uint32 ButtonEvents = 0;
+	for (int32 ActionType = 0; ActionType < VRInput::NumButtonActionTypes; ++ActionType) ButtonEvents |= Buttons << (ActionType * VRInput::ButtonEventBitsPerAction);
+	ButtonEventsMask &= ~static_cast<int32>(ButtonEvents);
+}
+
+void FVRInputFrame::ResetChanges()
+{
+	ChangedMask = 0;
+	ButtonEventsMask = 0;
+}
@@ -0,0 +1,79 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+
+#include "VRInputTypes.h"
+
+#include "VRInputFrame.generated.h"
+
+/**
+ * Coalesced input of one hand. Motion Controller fills it while ue4 processes input and delivers it once per Tick,
+ * so thumbstick X and Y are always received together and consumers can read every axis and button edge in one call
+ */
+USTRUCT(BlueprintType)
+struct PROJECTVRBASICS_API FVRInputFrame
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	float Thumbstick_X = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	float Thumbstick_Y = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	float Trigger = 0.f;
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	float Grip = 0.f;
+
+	// Controls that changed since previous frame, see VRInput::AxisBit() and VRInput::ButtonBit()
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	int32 ChangedMask = 0;
+	// Every button event of this frame. 8 bits per EButtonActionType, bit per EVRInputButton
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	int32 ButtonEventsMask = 0;
+	// Buttons that are held at the end of this frame. Bits 0-7 are pressed buttons, bits 8-15 are touched buttons
+	UPROPERTY(BlueprintReadOnly, Category = "VR Input Frame")
+	int32 ButtonStateMask = 0;
+
+	static FORCEINLINE uint32 ButtonEventBit(EVRInputButton Button, EButtonActionType ActionType) { return 1u << (static_cast<int32>(ActionType) * VRInput::ButtonEventBitsPerAction + VRInput::ToIndex(Button)); }
+
+	float GetAxis(EVRInputAxis Axis) const;
+	// Returns false if value did not change
+	bool SetAxis(EVRInputAxis Axis, float Value);
+	void AddButtonEvent(EVRInputButton Button, EButtonActionType ActionType);
+
+	FORCEINLINE bool HasChanges() const { return ChangedMask != 0; }
+	FORCEINLINE bool IsAxisChanged(EVRInputAxis Axis) const { return (static_cast<uint32>(ChangedMask) & VRInput::AxisBit(Axis)) != 0; }
+	FORCEINLINE bool HasButtonEvent(EVRInputButton Button, EButtonActionType ActionType) const { return (static_cast<uint32>(ButtonEventsMask) & ButtonEventBit(Button, ActionType)) != 0; }
+	FORCEINLINE bool IsButtonPressed(EVRInputButton Button) const { return (ButtonStateMask & (1 << VRInput::ToIndex(Button))) != 0; }
+	FORCEINLINE bool IsButtonTouched(EVRInputButton Button) const { return (ButtonStateMask & (1 << (VRInput::TouchedButtonsShift + VRInput::ToIndex(Button)))) != 0; }
+
+	// Removes changes and button events of controls in mask (f.e. controls that were consumed by another receiver)
+	void ClearControls(uint32 ControlsMask);
+	// Called after frame was delivered. Values and held buttons are kept
+	void ResetChanges();
+};
+
+/**
+ * Blueprint accessors for FVRInputFrame bits
+ */
+UCLASS()
+class PROJECTVRBASICS_API UVRInputFrameLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintPure, Category = "VR Input Frame")
+	static bool IsAxisChanged(const FVRInputFrame& Frame, EVRInputAxis Axis) { return Frame.IsAxisChanged(Axis); }
+	UFUNCTION(BlueprintPure, Category = "VR Input Frame")
+	static bool HasButtonEvent(const FVRInputFrame& Frame, EVRInputButton Button, EButtonActionType ActionType) { return Frame.HasButtonEvent(Button, ActionType); }
+	UFUNCTION(BlueprintPure, Category = "VR Input Frame")
+	static bool IsButtonPressed(const FVRInputFrame& Frame, EVRInputButton Button) { return Frame.IsButtonPressed(Button); }
+	UFUNCTION(BlueprintPure, Category = "VR Input Frame")
+	static bool IsButtonTouched(const FVRInputFrame& Frame, EVRInputButton Button) { return Frame.IsButtonTouched(Button); }
+	UFUNCTION(BlueprintPure, Category = "VR Input Frame")
+	static FVector2D GetThumbstick(const FVRInputFrame& Frame) { return FVector2D(Frame.Thumbstick_X, Frame.Thumbstick_Y); }
+};
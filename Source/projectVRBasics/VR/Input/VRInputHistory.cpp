@@ -0,0 +1,18 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInputHistory.h"
+
+
+void FVRInputHistory::Push(const FVRInputHistorySample& Sample)
+{
+	Samples[Head] = Sample;
+	Head = (Head + 1) % Capacity;
+	Count = FMath::Min(Count + 1, Capacity);
+}
+
+const FVRInputHistorySample& FVRInputHistory::GetFromLatest(int32 Age) const
+{
+	check(Age >= 0 && Age < Count);
+	return Samples[(Head - 1 - Age + Capacity) % Capacity];
+}
@@ -0,0 +1,39 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Input and pose of one hand at the end of a motion controller Tick
+struct FVRInputHistorySample
+{
+	double Time = 0.0;
+	FVector2D Thumbstick = FVector2D::ZeroVector;
+	float Trigger = 0.f;
+	float Grip = 0.f;
+	int32 ButtonStateMask = 0; // same layout as FVRInputFrame::ButtonStateMask
+	int32 PressedEventsMask = 0; // bit per EVRInputButton that got Pressed event this frame, so presses shorter than a frame are not lost
+	FVector Location = FVector::ZeroVector; // Relative to pawn`s VR root, so teleports do not look like hand movement
+};
+
+/**
+ * Fixed size ring of last samples of one hand. Oldest sample is overwritten, nothing is allocated after construction
+ */
+class PROJECTVRBASICS_API FVRInputHistory
+{
+public:
+	static constexpr int32 Capacity = 2; // Recognizers keep their own state over time and look only at the last two samples
+
+	void Push(const FVRInputHistorySample& Sample);
+	void Reset() { Head = 0; Count = 0; }
+
+	int32 Num() const { return Count; }
+	// 0 is the latest sample
+	const FVRInputHistorySample& GetFromLatest(int32 Age) const;
+	const FVRInputHistorySample& GetLatest() const { return GetFromLatest(0); }
+
+private:
+	FVRInputHistorySample Samples[Capacity];
+	int32 Head = 0; // next slot to write
+	int32 Count = 0;
+};
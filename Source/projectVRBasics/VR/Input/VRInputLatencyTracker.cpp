@@ -0,0 +1,160 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInputLatencyTracker.h"
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/CoreDelegates.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/Histogram.h"
+#include "Stats/Stats.h"
+
+#include "VRInputFrame.h"
+
+
+DECLARE_STATS_GROUP(TEXT("VR Input"), STATGROUP_VRInput, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Received Events"), STAT_VRInput_Received, STATGROUP_VRInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events To Forwarded Actor"), STAT_VRInput_ToActor, STATGROUP_VRInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events To Controller State"), STAT_VRInput_ToState, STATGROUP_VRInput);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Events To Controller BP"), STAT_VRInput_ToBlueprint, STATGROUP_VRInput);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Latency To Forwarded Actor (ms)"), STAT_VRInput_ToActorLatency, STATGROUP_VRInput);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Latency To Controller State (ms)"), STAT_VRInput_ToStateLatency, STATGROUP_VRInput);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Latency To Controller BP (ms)"), STAT_VRInput_ToBlueprintLatency, STATGROUP_VRInput);
+
+CSV_DEFINE_CATEGORY(VRInput, true);
+
+namespace VRInputLatency
+{
+	static TAutoConsoleVariable<int32> CVarEnabled(
+		TEXT("vr.InputLatency"),
+		0,
+		TEXT("Measure time from motion controller receiving input to every receiver getting it. See FVRInputLatencyTracker"));
+
+	static FAutoConsoleCommand DumpCommand(
+		TEXT("vr.InputLatency.Dump"),
+		TEXT("Print input latency histograms of every receiver to log and reset them"),
+		FConsoleCommandDelegate::CreateLambda([]() { FVRInputLatencyTracker::DumpHistograms(); FVRInputLatencyTracker::ResetHistograms(); }));
+
+	constexpr int32 NumStages = static_cast<int32>(EVRInputLatencyStage::Num);
+
+	// Axes may wait up to a frame, so two 60Hz frames cover everything that is not a hitch
+	constexpr double HistogramMaxMs = 33.0;
+	constexpr double HistogramBinMs = 0.5;
+
+	static const TCHAR* StageNames[NumStages] = { TEXT("Forwarded Actor"), TEXT("Controller State"), TEXT("Controller BP") };
+
+	struct FStageData
+	{
+		FHistogram Histogram;
+		int32 FrameEventsCount = 0;
+		double FrameMaxLatencyMs = 0.0;
+	};
+
+	struct FTrackerState
+	{
+		FStageData Stages[NumStages];
+		int32 FrameReceivedCount = 0;
+		bool bEndFrameBound = false;
+
+		FTrackerState()
+		{
+			for (FStageData& Stage : Stages) Stage.Histogram.InitLinear(0.0, HistogramMaxMs, HistogramBinMs);
+		}
+	};
+
+	static FTrackerState& GetState()
+	{
+		static FTrackerState State;
+		return State;
+	}
+
+	static void OnEndFrame()
+	{
+		FTrackerState& State = GetState();
+		const FStageData& ToActor = State.Stages[static_cast<int32>(EVRInputLatencyStage::ForwardedActor)];
+		const FStageData& ToState = State.Stages[static_cast<int32>(EVRInputLatencyStage::ControllerState)];
+		const FStageData& ToBlueprint = State.Stages[static_cast<int32>(EVRInputLatencyStage::ControllerBlueprint)];
+
+		SET_DWORD_STAT(STAT_VRInput_Received, State.FrameReceivedCount);
+		SET_DWORD_STAT(STAT_VRInput_ToActor, ToActor.FrameEventsCount);
+		SET_DWORD_STAT(STAT_VRInput_ToState, ToState.FrameEventsCount);
+		SET_DWORD_STAT(STAT_VRInput_ToBlueprint, ToBlueprint.FrameEventsCount);
+		SET_FLOAT_STAT(STAT_VRInput_ToActorLatency, ToActor.FrameMaxLatencyMs);
+		SET_FLOAT_STAT(STAT_VRInput_ToStateLatency, ToState.FrameMaxLatencyMs);
+		SET_FLOAT_STAT(STAT_VRInput_ToBlueprintLatency, ToBlueprint.FrameMaxLatencyMs);
+
+		CSV_CUSTOM_STAT(VRInput, ReceivedEvents, State.FrameReceivedCount, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(VRInput, ToActorEvents, ToActor.FrameEventsCount, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(VRInput, ToStateEvents, ToState.FrameEventsCount, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(VRInput, ToBlueprintEvents, ToBlueprint.FrameEventsCount, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(VRInput, ToActorMaxLatencyMs, static_cast<float>(ToActor.FrameMaxLatencyMs), ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(VRInput, ToStateMaxLatencyMs, static_cast<float>(ToState.FrameMaxLatencyMs), ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(VRInput, ToBlueprintMaxLatencyMs, static_cast<float>(ToBlueprint.FrameMaxLatencyMs), ECsvCustomStatOp::Set);
+
+		State.FrameReceivedCount = 0;
+		for (FStageData& Stage : State.Stages)
+		{
+			Stage.FrameEventsCount = 0;
+			Stage.FrameMaxLatencyMs = 0.0;
+		}
+	}
+}
+
+bool FVRInputLatencyTracker::IsEnabled()
+{
+	return VRInputLatency::CVarEnabled.GetValueOnGameThread() != 0;
+}
+
+double FVRInputLatencyTracker::GetReceiveTime()
+{
+	return IsEnabled() ? FPlatformTime::Seconds() : 0.0;
+}
+
+void FVRInputLatencyTracker::OnReceived()
+{
+	if (!IsEnabled()) return;
+
+	VRInputLatency::FTrackerState& State = VRInputLatency::GetState();
+	if (!State.bEndFrameBound) // Per frame counters are reported only after tracking was used once
+	{
+		FCoreDelegates::OnEndFrame.AddStatic(&VRInputLatency::OnEndFrame);
+		State.bEndFrameBound = true;
+	}
+
+	++State.FrameReceivedCount;
+}
+
+void FVRInputLatencyTracker::OnDelivered(EVRInputLatencyStage Stage, double ReceiveTime)
+{
+	if (ReceiveTime <= 0.0) return; // Received while tracking was disabled
+
+	const double LatencyMs = (FPlatformTime::Seconds() - ReceiveTime) * 1000.0;
+
+	VRInputLatency::FStageData& StageData = VRInputLatency::GetState().Stages[static_cast<int32>(Stage)];
+	StageData.Histogram.AddMeasurement(LatencyMs);
+	StageData.FrameMaxLatencyMs = FMath::Max(StageData.FrameMaxLatencyMs, LatencyMs);
+	++StageData.FrameEventsCount;
+}
+
+void FVRInputLatencyTracker::OnFrameDelivered(EVRInputLatencyStage Stage, const FVRInputFrame& Frame, const double* AxisReceiveTimes)
+{
+	for (int32 AxisIndex = 0; AxisIndex < VRInput::NumAxes; ++AxisIndex)
+	{
+		if (Frame.IsAxisChanged(static_cast<EVRInputAxis>(AxisIndex))) OnDelivered(Stage, AxisReceiveTimes[AxisIndex]);
+	}
+}
+
+void FVRInputLatencyTracker::DumpHistograms()
+{
+	for (int32 Stage = 0; Stage < VRInputLatency::NumStages; ++Stage)
+	{
+		VRInputLatency::GetState().Stages[Stage].Histogram.DumpToLog(FString::Printf(TEXT("VR input latency to %s (ms)"), VRInputLatency::StageNames[Stage]));
+	}
+}
+
+void FVRInputLatencyTracker::ResetHistograms()
+{
+	for (VRInputLatency::FStageData& Stage : VRInputLatency::GetState().Stages) Stage.Histogram.Reset();
+}
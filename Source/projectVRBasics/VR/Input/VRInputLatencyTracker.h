@@ -0,0 +1,39 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRInputTypes.h"
+
+struct FVRInputFrame;
+
+// Receivers of motion controller input in the order they get it
+enum class EVRInputLatencyStage : uint8 {
+	ForwardedActor,
+	ControllerState,
+	ControllerBlueprint,
+	Num
+};
+
+/**
+ * Measures time from the moment motion controller receives input from pawn (PawnInput_*) to the moment every receiver gets an event.
+ * Button events are sent right away so their latency is the cost of receivers in front. Axes are sent once per Tick so their latency also includes the wait for controller Tick.
+ * Enabled with vr.InputLatency 1. Reported as "stat VRInput", as VRInput category of CSV profiler and as histograms printed by vr.InputLatency.Dump
+ */
+class PROJECTVRBASICS_API FVRInputLatencyTracker
+{
+public:
+	static bool IsEnabled();
+
+	// 0 if tracking is disabled, so callers may store it unconditionally
+	static double GetReceiveTime();
+
+	static void OnReceived();
+	static void OnDelivered(EVRInputLatencyStage Stage, double ReceiveTime);
+	// Every changed axis of the frame. AxisReceiveTimes is indexed by EVRInputAxis
+	static void OnFrameDelivered(EVRInputLatencyStage Stage, const FVRInputFrame& Frame, const double* AxisReceiveTimes);
+
+	static void DumpHistograms();
+	static void ResetHistograms();
+};
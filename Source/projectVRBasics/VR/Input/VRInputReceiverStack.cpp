@@ -0,0 +1,71 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInputReceiverStack.h"
+
+#include "../Actors/Interfaces/VRInterfaceDispatch.h"
+
+
+void FVRInputReceiverStack::SetReceiver(EVRInputReceiverSlot Slot, UObject* Receiver)
+{
+	TWeakObjectPtr<UObject>& SlotReceiver = Receivers[static_cast<int32>(Slot)];
+	if (SlotReceiver == TWeakObjectPtr<UObject>(Receiver)) return; // Stale receiver differs from nullptr, so routes of destroyed one are dropped
+
+	SlotReceiver = Receiver;
+	bDirty = true;
+}
+
+bool FVRInputReceiverStack::Contains(const UObject* Receiver) const
+{
+	for (const TWeakObjectPtr<UObject>& SlotReceiver : Receivers)
+	{
+		if (SlotReceiver.Get() == Receiver) return true;
+	}
+	return false;
+}
+
+void FVRInputReceiverStack::Rebuild()
+{
+	const uint32 AllControlsMask = VRInput::AllAxesMask | VRInput::AllButtonsMask;
+	uint32 ConsumedMask = 0;
+
+	for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+	{
+		UObject* Receiver = Receivers[Slot].Get();
+		const bool bWorldObject = Slot == static_cast<int32>(EVRInputReceiverSlot::HeldObject) || Slot == static_cast<int32>(EVRInputReceiverSlot::PointedObject);
+		const bool bController = Slot == static_cast<int32>(EVRInputReceiverSlot::Controller);
+
+		// Pointing at the held object should not deliver its input twice
+		const bool bDuplicate = Slot == static_cast<int32>(EVRInputReceiverSlot::PointedObject) && Receiver == Receivers[static_cast<int32>(EVRInputReceiverSlot::HeldObject)].Get();
+
+		if (!Receiver || bDuplicate)
+		{
+			RouteMasks[Slot] = 0;
+			continue;
+		}
+
+		if (bController)
+		{
+			RouteMasks[Slot] = AllControlsMask;
+			continue;
+		}
+
+		RouteMasks[Slot] = AllControlsMask & ~ConsumedMask & (bWorldObject ? ~VRInput::NotForwardedToActorsMask : AllControlsMask);
+
+		// Only world objects declare consumed controls, and only controls they actually receive may be consumed
+		if (bWorldObject) ConsumedMask |= FVRInterfaceDispatch::GetConsumeInputParams(Receiver).GetControlsMask() & RouteMasks[Slot];
+	}
+
+	for (int32 ButtonIndex = 0; ButtonIndex < VRInput::NumButtons; ++ButtonIndex)
+	{
+		const uint32 Bit = VRInput::ButtonBit(static_cast<EVRInputButton>(ButtonIndex));
+
+		ButtonRoutes[ButtonIndex] = 0;
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			if (RouteMasks[Slot] & Bit) ButtonRoutes[ButtonIndex] |= SlotBit(Slot);
+		}
+	}
+
+	bDirty = false;
+}
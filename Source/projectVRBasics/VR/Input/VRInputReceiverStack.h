@@ -0,0 +1,50 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRInputTypes.h"
+
+// Receivers of one hand`s input from highest to lowest priority
+enum class EVRInputReceiverSlot : uint8 {
+	HeldObject,
+	PointedObject,
+	ControllerState,
+	Controller,
+	Num
+};
+
+/**
+ * Priority stack of objects that receive input of one motion controller. Every receiver gets controls that were not consumed by receivers above it (see IVRPlayerInput::GetConsumeInputParams),
+ * world objects (held and pointed) never get Menu and System, controller itself always gets everything.
+ * Routes are computed once when a receiver changes or is invalidated, events are then sent using precomputed masks only
+ */
+class PROJECTVRBASICS_API FVRInputReceiverStack
+{
+public:
+	static constexpr int32 NumSlots = static_cast<int32>(EVRInputReceiverSlot::Num);
+
+	static FORCEINLINE uint8 SlotBit(int32 Slot) { return 1 << Slot; }
+
+	// Marks stack dirty if receiver changed
+	void SetReceiver(EVRInputReceiverSlot Slot, UObject* Receiver);
+	// Consume params of some receiver changed
+	void Invalidate() { bDirty = true; }
+	bool IsDirty() const { return bDirty; }
+	void Rebuild();
+
+	UObject* GetReceiver(int32 Slot) const { return Receivers[Slot].Get(); }
+	bool Contains(const UObject* Receiver) const;
+
+	// Controls (VRInput::AxisBit() and VRInput::ButtonBit()) that receiver in this slot gets
+	uint32 GetRouteMask(int32 Slot) const { return RouteMasks[Slot]; }
+	// SlotBit() of every receiver that gets this button
+	uint8 GetButtonRoutes(EVRInputButton Button) const { return ButtonRoutes[VRInput::ToIndex(Button)]; }
+
+private:
+	TWeakObjectPtr<UObject> Receivers[NumSlots];
+	uint32 RouteMasks[NumSlots] = {};
+	uint8 ButtonRoutes[VRInput::NumButtons] = {};
+	bool bDirty = true;
+};
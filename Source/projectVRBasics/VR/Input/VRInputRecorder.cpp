@@ -0,0 +1,225 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInputRecorder.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+
+
+namespace VRInputRecorderCommandLine
+{
+	static const TCHAR* Record = TEXT("VRInputRecord=");
+	static const TCHAR* Replay = TEXT("VRInputReplay=");
+
+	static FString ToFullPath(const FString& FilePath)
+	{
+		if (FPaths::IsRelative(FilePath)) return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("VRInput"), FilePath);
+		return FilePath;
+	}
+}
+
+TSharedPtr<FVRInputRecorder> FVRInputRecorder::CreateFromCommandLine()
+{
+	FString FilePath;
+	if (FParse::Value(FCommandLine::Get(), VRInputRecorderCommandLine::Replay, FilePath))
+	{
+		return MakeShared<FVRInputRecorder>(EVRInputRecorderMode::Replaying, VRInputRecorderCommandLine::ToFullPath(FilePath));
+	}
+	if (FParse::Value(FCommandLine::Get(), VRInputRecorderCommandLine::Record, FilePath))
+	{
+		return MakeShared<FVRInputRecorder>(EVRInputRecorderMode::Recording, VRInputRecorderCommandLine::ToFullPath(FilePath));
+	}
+	return nullptr;
+}
+
+bool FVRInputRecorder::IsReplayRequestedOnCommandLine()
+{
+	FString FilePath;
+	return FParse::Value(FCommandLine::Get(), VRInputRecorderCommandLine::Replay, FilePath);
+}
+
+FVRInputRecorder::FVRInputRecorder(EVRInputRecorderMode InMode, const FString& InFilePath)
+	: Mode(InMode)
+	, FilePath(InFilePath)
+{
+	for (float& Value : LastAxisValues) Value = 0.f;
+}
+
+FVRInputRecorder::~FVRInputRecorder()
+{
+	Close();
+}
+
+bool FVRInputRecorder::OpenForRecording(FName ControllersTypeName)
+{
+	if (Mode != EVRInputRecorderMode::Recording) return false;
+
+	Archive.Reset(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!Archive.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not create VR input record file %s"), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = StreamMagic;
+	uint32 Version = StreamVersion;
+	FString TypeName = ControllersTypeName.ToString(); // FName is not serialized by plain file archives
+	*Archive << Magic << Version << TypeName;
+
+	UE_LOG(LogTemp, Log, TEXT("Recording VR input to %s"), *FilePath);
+	return true;
+}
+
+bool FVRInputRecorder::OpenForReplay(FName& OutControllersTypeName)
+{
+	if (Mode != EVRInputRecorderMode::Replaying) return false;
+
+	Archive.Reset(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Archive.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not open VR input record file %s"), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	FString TypeName;
+	*Archive << Magic << Version;
+
+	if (Magic != StreamMagic || Version != StreamVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a VR input record or its version is not supported"), *FilePath);
+		Archive.Reset();
+		return false;
+	}
+
+	*Archive << TypeName;
+	OutControllersTypeName = FName(*TypeName);
+
+	UE_LOG(LogTemp, Log, TEXT("Replaying VR input from %s"), *FilePath);
+	return true;
+}
+
+void FVRInputRecorder::Close()
+{
+	if (!Archive.IsValid()) return;
+
+	Archive->Close();
+	Archive.Reset();
+
+	UE_LOG(LogTemp, Log, TEXT("VR input %s closed after %d frames"), *FilePath, FramesCount);
+}
+
+void FVRInputRecorder::RecordAxis(int32 RowIndex, float Value)
+{
+	if (!IsRecording() || !ensure(RowIndex >= 0 && RowIndex < MaxRowsCount)) return;
+	if (LastAxisValues[RowIndex] == Value) return;
+
+	LastAxisValues[RowIndex] = Value;
+
+	FVRInputRecordedEvent& Event = PendingEvents.AddDefaulted_GetRef();
+	Event.RowIndex = static_cast<uint8>(RowIndex);
+	Event.Value = Value;
+}
+
+void FVRInputRecorder::RecordAction(int32 RowIndex, bool bReleased)
+{
+	if (!IsRecording() || !ensure(RowIndex >= 0 && RowIndex < MaxRowsCount)) return;
+
+	FVRInputRecordedEvent& Event = PendingEvents.AddDefaulted_GetRef();
+	Event.RowIndex = static_cast<uint8>(RowIndex);
+	Event.bAction = true;
+	Event.bReleased = bReleased;
+}
+
+void FVRInputRecorder::EndFrame(float DeltaTime, const FVRInputRecordedPoses& Poses)
+{
+	if (!IsRecording()) return;
+
+	FArchive& Ar = *Archive;
+	FVRInputRecordedPoses PosesToWrite = Poses;
+	int32 EventsCount = PendingEvents.Num();
+
+	Ar << DeltaTime;
+	SerializePose(Ar, PosesToWrite.HMD);
+	SerializePose(Ar, PosesToWrite.LeftController);
+	SerializePose(Ar, PosesToWrite.RightController);
+	Ar << EventsCount;
+
+	for (int32 i = 0; i < EventsCount; ++i)
+	{
+		FVRInputRecordedEvent& Event = PendingEvents[i];
+		uint8 PackedEvent = Event.RowIndex | (Event.bAction ? ActionBit : 0) | (Event.bReleased ? ReleasedBit : 0);
+		Ar << PackedEvent;
+		if (!Event.bAction) Ar << Event.Value;
+	}
+
+	PendingEvents.Reset();
+	++FramesCount;
+}
+
+bool FVRInputRecorder::ReadFrame(float& OutDeltaTime, FVRInputRecordedPoses& OutPoses, TArray<FVRInputRecordedEvent>& OutEvents)
+{
+	OutEvents.Reset();
+	if (!IsReplaying() || Archive->AtEnd()) return false;
+
+	FArchive& Ar = *Archive;
+	int32 EventsCount = 0;
+
+	Ar << OutDeltaTime;
+	SerializePose(Ar, OutPoses.HMD);
+	SerializePose(Ar, OutPoses.LeftController);
+	SerializePose(Ar, OutPoses.RightController);
+	Ar << EventsCount;
+
+	if (EventsCount < 0 || Ar.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("VR input record %s is corrupted at frame %d"), *FilePath, FramesCount);
+		return false;
+	}
+
+	for (int32 i = 0; i < EventsCount; ++i)
+	{
+		uint8 PackedEvent = 0;
+		Ar << PackedEvent;
+
+		FVRInputRecordedEvent& Event = OutEvents.AddDefaulted_GetRef();
+		Event.RowIndex = PackedEvent & RowIndexMask;
+		Event.bAction = (PackedEvent & ActionBit) != 0;
+		Event.bReleased = (PackedEvent & ReleasedBit) != 0;
+		if (!Event.bAction) Ar << Event.Value;
+	}
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("VR input record %s is truncated at frame %d"), *FilePath, FramesCount);
+		return false;
+	}
+
+	++FramesCount;
+	return true;
+}
+
+bool FVRInputRecorder::PeekDeltaTime(float& OutDeltaTime)
+{
+	if (!IsReplaying() || Archive->AtEnd()) return false;
+
+	const int64 FramePosition = Archive->Tell();
+	*Archive << OutDeltaTime;
+	Archive->Seek(FramePosition);
+
+	return !Archive->IsError();
+}
+
+void FVRInputRecorder::SerializePose(FArchive& Ar, FTransform& Pose)
+{
+	// Scale is never tracked, so only location and rotation are stored
+	FVector Location = Pose.GetLocation();
+	FQuat Rotation = Pose.GetRotation();
+
+	Ar << Location << Rotation;
+
+	if (Ar.IsLoading()) Pose = FTransform(Rotation, Location);
+}
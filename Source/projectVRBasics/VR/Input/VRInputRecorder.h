@@ -0,0 +1,89 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FArchive;
+
+enum class EVRInputRecorderMode : uint8 {
+	None,
+	Recording,
+	Replaying
+};
+
+// Tracked transforms relative to pawn`s VR root: HMD is a camera transform, controllers are motion controller component transforms
+struct FVRInputRecordedPoses
+{
+	FTransform HMD;
+	FTransform LeftController;
+	FTransform RightController;
+};
+
+// One input event that reached the pawn. RowIndex is an index in pawn`s axis or action binding table
+struct FVRInputRecordedEvent
+{
+	uint8 RowIndex = 0;
+	bool bAction = false;
+	bool bReleased = false; // Actions only
+	float Value = 0.f; // Axes only
+};
+
+/**
+ * Writes input that reaches AVirtualRealityPawn and tracked poses into a compact binary stream and reads it back, so grab, teleport and pointing scenarios may be replayed with no headset attached.
+ * Enabled from command line: -VRInputRecord=File or -VRInputReplay=File (relative paths are inside Saved/VRInput). -VRInputReplayQuit exits the game when replay ends.
+ * One stream frame is one pawn Tick. Replay runs with fixed time step set to delta time of the next recorded frame, so every replayed frame has the same delta time it was recorded with.
+ *
+ * Stream layout: header (magic, version, controllers type name), then frames until end of file:
+ * delta time, three poses (location and rotation quat), events count (int32) and events. Event is one byte (bit 7 is action, bit 6 is release, rest is row index) and a float value for axes.
+ * Axes are written only when their value changed, pawn ignores repeated axis values anyway
+ */
+class PROJECTVRBASICS_API FVRInputRecorder
+{
+public:
+	// Returns nullptr if neither recording nor replay was requested
+	static TSharedPtr<FVRInputRecorder> CreateFromCommandLine();
+	static bool IsReplayRequestedOnCommandLine();
+
+	FVRInputRecorder(EVRInputRecorderMode InMode, const FString& InFilePath);
+	~FVRInputRecorder();
+
+	static constexpr int32 MaxRowsCount = 64;
+
+	EVRInputRecorderMode GetMode() const { return Mode; }
+	bool IsRecording() const { return Mode == EVRInputRecorderMode::Recording && Archive.IsValid(); }
+	bool IsReplaying() const { return Mode == EVRInputRecorderMode::Replaying && Archive.IsValid(); }
+	const FString& GetFilePath() const { return FilePath; }
+
+	bool OpenForRecording(FName ControllersTypeName);
+	bool OpenForReplay(FName& OutControllersTypeName);
+	void Close();
+
+	// Recording
+	void RecordAxis(int32 RowIndex, float Value);
+	void RecordAction(int32 RowIndex, bool bReleased);
+	void EndFrame(float DeltaTime, const FVRInputRecordedPoses& Poses);
+
+	// Replay. Returns false when stream has ended
+	bool ReadFrame(float& OutDeltaTime, FVRInputRecordedPoses& OutPoses, TArray<FVRInputRecordedEvent>& OutEvents);
+	// Delta time of the frame ReadFrame will return next, without reading it
+	bool PeekDeltaTime(float& OutDeltaTime);
+
+private:
+	static constexpr uint32 StreamMagic = 0x52495256; // "VRIR"
+	static constexpr uint32 StreamVersion = 2; // 2: events count is int32
+
+	static constexpr uint8 ActionBit = 1 << 7;
+	static constexpr uint8 ReleasedBit = 1 << 6;
+	static constexpr uint8 RowIndexMask = ReleasedBit - 1;
+
+	static void SerializePose(FArchive& Ar, FTransform& Pose);
+
+	EVRInputRecorderMode Mode;
+	FString FilePath;
+	TUniquePtr<FArchive> Archive;
+
+	TArray<FVRInputRecordedEvent> PendingEvents;
+	float LastAxisValues[MaxRowsCount];
+	int32 FramesCount = 0;
+};
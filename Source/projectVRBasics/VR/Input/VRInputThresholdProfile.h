@@ -0,0 +1,49 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+
+#include "VRInputThresholdProfile.generated.h"
+
+// Touch and Press thresholds of one analog button. Button becomes touched or pressed when value goes above Enter and is released only when value goes below Exit
+USTRUCT(BlueprintType)
+struct PROJECTVRBASICS_API FVRAnalogButtonThresholds
+{
+	GENERATED_BODY()
+
+public:
+	// Touch events come from controller`s own capacitive sensor bindings, touch thresholds are ignored
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thresholds")
+	bool bCapacitiveTouch = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thresholds", meta = (EditCondition = "!bCapacitiveTouch", ClampMin = "0", ClampMax = "1"))
+	float TouchEnter = 0.01f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thresholds", meta = (EditCondition = "!bCapacitiveTouch", ClampMin = "0", ClampMax = "1"))
+	float TouchExit = 0.005f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thresholds", meta = (ClampMin = "0", ClampMax = "1"))
+	float PressEnter = 0.95f;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thresholds", meta = (ClampMin = "0", ClampMax = "1"))
+	float PressExit = 0.85f;
+
+	// Value must stay on the other side of a threshold for that long before state changes. 0 to change right away
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Thresholds", meta = (ClampMin = "0", Units = "s"))
+	float DebounceTime = 0.f;
+};
+
+/**
+ * Analog Trigger and Grip settings of one headset`s controllers. Selected by AVirtualRealityPawn together with controller classes (see FControllerType)
+ */
+UCLASS(BlueprintType)
+class PROJECTVRBASICS_API UVRInputThresholdProfile : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Input Thresholds")
+	FVRAnalogButtonThresholds Trigger;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "VR Input Thresholds")
+	FVRAnalogButtonThresholds Grip;
+};
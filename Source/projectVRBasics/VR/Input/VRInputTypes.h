@@ -0,0 +1,81 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRInputTypes.generated.h"
+
+UENUM(BlueprintType)
+enum class EButtonActionType : uint8 {
+	Touched = 0 UMETA(DisplayName = "Touched"),
+	Pressed = 1 UMETA(DisplayName = "Pressed"),
+	ReleasedPress = 2 UMETA(DisplayName = "Released Press"),
+	ReleasedTouch = 3 UMETA(DisplayName = "Released Touch")
+};
+
+// Keys of the input binding table. Pawn receives ue4 input, looks up a table row by index and forwards it to the hand from that row using these enums instead of a separate function for every control
+
+UENUM(BlueprintType)
+enum class EVRInputHand : uint8 {
+	Left = 0 UMETA(DisplayName = "Left"),
+	Right = 1 UMETA(DisplayName = "Right"),
+	Num = 2 UMETA(Hidden)
+};
+
+UENUM(BlueprintType)
+enum class EVRInputAxis : uint8 {
+	Thumbstick_X = 0 UMETA(DisplayName = "Thumbstick X"),
+	Thumbstick_Y = 1 UMETA(DisplayName = "Thumbstick Y"),
+	Trigger = 2 UMETA(DisplayName = "Trigger"),
+	Grip = 3 UMETA(DisplayName = "Grip"),
+	Num = 4 UMETA(Hidden)
+};
+
+UENUM(BlueprintType)
+enum class EVRInputButton : uint8 {
+	Primary = 0 UMETA(DisplayName = "Primary"),
+	Secondary = 1 UMETA(DisplayName = "Secondary"),
+	Thumbstick = 2 UMETA(DisplayName = "Thumbstick"),
+	Trigger = 3 UMETA(DisplayName = "Trigger"),
+	Grip = 4 UMETA(DisplayName = "Grip"),
+	Menu = 5 UMETA(DisplayName = "Menu"),
+	System = 6 UMETA(DisplayName = "System"),
+	Num = 7 UMETA(Hidden)
+};
+
+// Analog axes that also produce Touch and Press button events using thresholds (see AVirtualRealityPawn)
+enum class EVRAnalogButton : uint8 {
+	Trigger = 0,
+	Grip = 1,
+	Num = 2
+};
+
+namespace VRInput
+{
+	constexpr int32 NumHands = static_cast<int32>(EVRInputHand::Num);
+	constexpr int32 NumAxes = static_cast<int32>(EVRInputAxis::Num);
+	constexpr int32 NumButtons = static_cast<int32>(EVRInputButton::Num);
+	constexpr int32 NumAnalogButtons = static_cast<int32>(EVRAnalogButton::Num);
+
+	FORCEINLINE int32 ToIndex(EVRInputHand Hand) { return static_cast<int32>(Hand); }
+	FORCEINLINE int32 ToIndex(EVRInputAxis Axis) { return static_cast<int32>(Axis); }
+	FORCEINLINE int32 ToIndex(EVRInputButton Button) { return static_cast<int32>(Button); }
+	FORCEINLINE int32 ToIndex(EVRAnalogButton AnalogButton) { return static_cast<int32>(AnalogButton); }
+
+	FORCEINLINE EVRInputButton ToButton(EVRAnalogButton AnalogButton) { return AnalogButton == EVRAnalogButton::Trigger ? EVRInputButton::Trigger : EVRInputButton::Grip; }
+
+	// Controls mask layout shared by input frames and consume params: bit per axis starting from 0, bit per button starting from 8
+	constexpr int32 ButtonBitsShift = 8;
+	constexpr int32 NumButtonActionTypes = static_cast<int32>(EButtonActionType::ReleasedTouch) + 1;
+	constexpr int32 ButtonEventBitsPerAction = 8; // FVRInputFrame::ButtonEventsMask has one byte of button bits per EButtonActionType
+	constexpr int32 TouchedButtonsShift = 8; // FVRInputFrame::ButtonStateMask has pressed buttons in low byte and touched buttons in next one
+	constexpr uint32 AllAxesMask = (1u << NumAxes) - 1;
+	constexpr uint32 AllButtonsMask = ((1u << NumButtons) - 1) << ButtonBitsShift;
+
+	FORCEINLINE uint32 AxisBit(EVRInputAxis Axis) { return 1u << ToIndex(Axis); }
+	FORCEINLINE uint32 ButtonBit(EVRInputButton Button) { return 1u << (ButtonBitsShift + ToIndex(Button)); }
+
+	// Menu and System belong to the player, they never go to world objects
+	constexpr uint32 NotForwardedToActorsMask = (1u << (ButtonBitsShift + static_cast<int32>(EVRInputButton::Menu))) | (1u << (ButtonBitsShift + static_cast<int32>(EVRInputButton::System)));
+}
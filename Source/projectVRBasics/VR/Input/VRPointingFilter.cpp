@@ -0,0 +1,46 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRPointingFilter.h"
+
+
+FVector FVROneEuroFilter::Filter(const FVector& Value, float DeltaTime, float MinCutoff, float Beta, float DerivativeCutoff)
+{
+	if (!bHasValue)
+	{
+		FilteredValue = Value;
+		FilteredDerivative = FVector::ZeroVector;
+		bHasValue = true;
+		return FilteredValue;
+	}
+	if (DeltaTime <= 0.f) return FilteredValue; // Paused
+
+	const FVector Derivative = (Value - FilteredValue) / DeltaTime;
+	FilteredDerivative = FMath::Lerp(FilteredDerivative, Derivative, GetSmoothingFactor(DerivativeCutoff, DeltaTime));
+
+	const float Cutoff = MinCutoff + Beta * FilteredDerivative.Size();
+	FilteredValue = FMath::Lerp(FilteredValue, Value, GetSmoothingFactor(Cutoff, DeltaTime));
+
+	return FilteredValue;
+}
+
+float FVROneEuroFilter::GetSmoothingFactor(float Cutoff, float DeltaTime)
+{
+	const float TimeConstant = 1.f / (2.f * PI * Cutoff);
+	return 1.f / (1.f + TimeConstant / DeltaTime);
+}
+
+void FVRPointingFilter::Filter(FVector& InOutOrigin, FVector& InOutDirection, float DeltaTime, const FVRPointingFilterSettings& Settings)
+{
+	InOutOrigin = OriginFilter.Filter(InOutOrigin, DeltaTime, Settings.MinCutoff, Settings.LocationBeta, Settings.DerivativeCutoff);
+
+	// Derivative of a unit vector is close to angular speed in rad/s for small steps
+	const FVector FilteredDirection = DirectionFilter.Filter(InOutDirection, DeltaTime, Settings.MinCutoff, Settings.DirectionBeta, Settings.DerivativeCutoff);
+	InOutDirection = FilteredDirection.GetSafeNormal(SMALL_NUMBER, InOutDirection);
+}
+
+void FVRPointingFilter::Reset()
+{
+	OriginFilter.Reset();
+	DirectionFilter.Reset();
+}
@@ -0,0 +1,60 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "VRPointingFilter.generated.h"
+
+// One Euro filter parameters (Casiez et al. 2012): cutoff frequency grows with speed, so slow movement (tremor) is smoothed heavily and fast movement has almost no lag
+USTRUCT(BlueprintType)
+struct PROJECTVRBASICS_API FVRPointingFilterSettings
+{
+	GENERATED_BODY()
+
+public:
+	// Cutoff frequency while hand is still, lower is smoother
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Controller Setup - Pointing", meta = (ClampMin = "0.01", Units = "Hz"))
+	float MinCutoff = 1.f;
+	// Cutoff increase per cm/s of ray origin speed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Controller Setup - Pointing", meta = (ClampMin = "0"))
+	float LocationBeta = 0.01f;
+	// Cutoff increase per rad/s of ray direction speed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Controller Setup - Pointing", meta = (ClampMin = "0"))
+	float DirectionBeta = 1.f;
+	// Cutoff of speed estimation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion Controller Setup - Pointing", meta = (ClampMin = "0.01", Units = "Hz"))
+	float DerivativeCutoff = 1.f;
+};
+
+/**
+ * One Euro filter of a vector. Speed used for cutoff is the length of vector derivative
+ */
+class PROJECTVRBASICS_API FVROneEuroFilter
+{
+public:
+	FVector Filter(const FVector& Value, float DeltaTime, float MinCutoff, float Beta, float DerivativeCutoff);
+	void Reset() { bHasValue = false; }
+
+private:
+	static float GetSmoothingFactor(float Cutoff, float DeltaTime);
+
+	FVector FilteredValue = FVector::ZeroVector;
+	FVector FilteredDerivative = FVector::ZeroVector;
+	bool bHasValue = false;
+};
+
+/**
+ * Smooths pointing ray of one controller: origin and direction are filtered separately, direction stays normalized
+ */
+class PROJECTVRBASICS_API FVRPointingFilter
+{
+public:
+	// Ray must be in a space that does not move with the pawn (f.e. relative to pawn`s VR root), otherwise locomotion would lag
+	void Filter(FVector& InOutOrigin, FVector& InOutDirection, float DeltaTime, const FVRPointingFilterSettings& Settings);
+	void Reset();
+
+private:
+	FVROneEuroFilter OriginFilter;
+	FVROneEuroFilter DirectionFilter;
+};
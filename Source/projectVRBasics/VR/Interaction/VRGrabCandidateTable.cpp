@@ -0,0 +1,237 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRGrabCandidateTable.h"
+
+#include "GameFramework/Actor.h"
+
+#include "../Actors/VRMotionControllerHand.h"
+#include "../Actors/Interfaces/HandInteractable.h"
+#include "../Actors/Interfaces/VRInterfaceCache.h"
+#include "../Actors/ActorComponents/VRGrabPointComponent.h"
+
+
+bool FVRGrabCandidateTable::AddReference(AActor* Actor)
+{
+	if (!Actor) return false;
+
+	const int32 ExistingIndex = Find(Actor);
+	if (ExistingIndex != INDEX_NONE)
+	{
+		++ReferenceCounts[ExistingIndex];
+		return false;
+	}
+
+	RemoveDestroyed(); // So new actor at the address of a destroyed one does not collide with it in Indices
+
+	// Every Blueprint that implements the interface gets a graph for GetWorldSquaredDistanceToMotionController, so whether it is really overridden can only be told by the actor itself
+	uint8 CandidateFlags = 0;
+	if (IHandInteractable::Execute_UsesCustomGrabDistance(Actor))
+	{
+		CandidateFlags |= BlueprintDistance;
+		++BlueprintDistancesNum;
+	}
+
+	const UVRGrabPointComponent* GrabPoint = Actor->FindComponentByClass<UVRGrabPointComponent>();
+
+	Indices.Add(Actor, Actors.Num());
+	Actors.Add(Actor);
+	Keys.Add(Actor);
+	LocalGrabPoints.Add(GrabPoint ? Actor->GetActorTransform().InverseTransformPosition(GrabPoint->GetComponentLocation()) : FVector::ZeroVector);
+	Flags.Add(CandidateFlags);
+	NativeInterfaces.Add(FVRInterfaceCache::ImplementsNatively(Actor, EVRInterface::HandInteractable) ? Cast<IHandInteractable>(Actor) : nullptr); // Native events are cheap, so C++ implementers are asked every call
+	ReferenceCounts.Add(1);
+	bLanesDirty = true;
+
+	return true;
+}
+
+bool FVRGrabCandidateTable::RemoveReference(const AActor* Actor)
+{
+	const int32 Index = Find(Actor);
+	if (Index == INDEX_NONE) return false;
+
+	if (--ReferenceCounts[Index] > 0) return false;
+
+	RemoveAt(Index);
+	return true;
+}
+
+void FVRGrabCandidateTable::Reset()
+{
+	Actors.Reset();
+	Keys.Reset();
+	LocalGrabPoints.Reset();
+	Flags.Reset();
+	BlueprintDistancesNum = 0;
+	NativeInterfaces.Reset();
+	ReferenceCounts.Reset();
+	Indices.Reset();
+	bLanesDirty = true;
+}
+
+int32 FVRGrabCandidateTable::Find(const AActor* Actor) const
+{
+	const int32* Index = Indices.Find(Actor);
+	return Index && Actors[*Index].Get() == Actor ? *Index : INDEX_NONE;
+}
+
+void FVRGrabCandidateTable::GetActors(TArray<AActor*>& OutActors)
+{
+	RemoveDestroyed();
+
+	OutActors.Reset(Actors.Num());
+	for (const TWeakObjectPtr<AActor>& Actor : Actors) OutActors.Add(Actor.Get());
+}
+
+void FVRGrabCandidateTable::RemoveAt(int32 Index)
+{
+	const int32 LastIndex = Actors.Num() - 1;
+
+	if (Flags[Index] & BlueprintDistance) --BlueprintDistancesNum;
+
+	Indices.Remove(Keys[Index]);
+	if (Index != LastIndex) Indices.Add(Keys[LastIndex], Index); // Last one is swapped into the removed slot
+
+	Actors.RemoveAtSwap(Index, 1, false);
+	Keys.RemoveAtSwap(Index, 1, false);
+	LocalGrabPoints.RemoveAtSwap(Index, 1, false);
+	Flags.RemoveAtSwap(Index, 1, false);
+	NativeInterfaces.RemoveAtSwap(Index, 1, false);
+	ReferenceCounts.RemoveAtSwap(Index, 1, false);
+	bLanesDirty = true;
+}
+
+void FVRGrabCandidateTable::RemoveDestroyed()
+{
+	for (int32 Index = Actors.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Actors[Index].IsValid()) RemoveAt(Index);
+	}
+}
+
+int32 FVRGrabCandidateTable::FindClosest(const AVRMotionControllerHand* Hand, const FVector& HandLocation, bool bAskBlueprints)
+{
+	RemoveDestroyed();
+	if (Actors.Num() == 0) return INDEX_NONE;
+
+	RefreshLanes(Hand, bAskBlueprints);
+	return FindClosestLane(PositionsX.GetData(), PositionsY.GetData(), PositionsZ.GetData(), CustomDistances.GetData(), CustomMasks.GetData(), Penalties.GetData(), PositionsX.Num(), HandLocation);
+}
+
+void FVRGrabCandidateTable::RefreshLanes(const AVRMotionControllerHand* Hand, bool bAskBlueprints)
+{
+	if (bLanesDirty) RebuildLanes();
+
+	for (int32 Index = 0; Index < Actors.Num(); ++Index)
+	{
+		AActor* Actor = Actors[Index].Get();
+		if (!Actor)
+		{
+			Penalties[Index] = MAX_flt; // Destroyed actor
+			continue;
+		}
+
+		// Most candidates lie still while hand moves around them
+		if (!LaneActorTransforms[Index].Equals(Actor->GetActorTransform(), 0.f)) UpdateGrabPointLane(Index, Actor);
+
+		// C++ implementer that does not override distance returns false and is measured natively
+		const IHandInteractable* NativeInterface = NativeInterfaces[Index];
+		bool bCustomDistance = NativeInterface && NativeInterface->NativeGetWorldSquaredDistanceToMotionController(Hand, CustomDistances[Index]);
+		if (!bCustomDistance && bAskBlueprints && (Flags[Index] & BlueprintDistance))
+		{
+			CustomDistances[Index] = IHandInteractable::Execute_GetWorldSquaredDistanceToMotionController(Actor, Hand);
+			bCustomDistance = true;
+		}
+		CustomMasks[Index] = bCustomDistance ? 1.f : 0.f;
+
+		bool bGrabDisabled = false;
+		const bool bNativeGrabDisabled = NativeInterface && NativeInterface->NativeIsGrabDisabled(bGrabDisabled);
+		if (!bNativeGrabDisabled && bAskBlueprints) bGrabDisabled = IHandInteractable::Execute_IsGrabDisabled(Actor);
+		Penalties[Index] = bGrabDisabled ? MAX_flt : 0.f;
+	}
+}
+
+void FVRGrabCandidateTable::RebuildLanes()
+{
+	bLanesDirty = false;
+
+	const int32 LanesNum = Align(Actors.Num(), 4);
+	PositionsX.SetNumUninitialized(LanesNum, false);
+	PositionsY.SetNumUninitialized(LanesNum, false);
+	PositionsZ.SetNumUninitialized(LanesNum, false);
+	CustomDistances.SetNumUninitialized(LanesNum, false);
+	CustomMasks.SetNumUninitialized(LanesNum, false);
+	Penalties.SetNumUninitialized(LanesNum, false);
+	LaneActorTransforms.SetNumUninitialized(Actors.Num(), false);
+
+	for (int32 Index = 0; Index < LanesNum; ++Index)
+	{
+		const AActor* Actor = Index < Actors.Num() ? Actors[Index].Get() : nullptr;
+
+		PositionsX[Index] = PositionsY[Index] = PositionsZ[Index] = 0.f;
+		CustomDistances[Index] = 0.f;
+		CustomMasks[Index] = 0.f;
+		Penalties[Index] = Actor ? 0.f : MAX_flt; // Padding or destroyed actor
+
+		if (Actor) UpdateGrabPointLane(Index, Actor);
+	}
+}
+
+void FVRGrabCandidateTable::UpdateGrabPointLane(int32 Index, const AActor* Actor)
+{
+	LaneActorTransforms[Index] = Actor->GetActorTransform();
+
+	const FVector GrabPoint = LaneActorTransforms[Index].TransformPosition(LocalGrabPoints[Index]);
+	PositionsX[Index] = GrabPoint.X;
+	PositionsY[Index] = GrabPoint.Y;
+	PositionsZ[Index] = GrabPoint.Z;
+}
+
+int32 FVRGrabCandidateTable::FindClosestLane(const float* X, const float* Y, const float* Z, const float* CustomDistances, const float* CustomMasks, const float* Penalties, int32 LanesNum, const FVector& Location)
+{
+	const VectorRegister LocationX = VectorSetFloat1(Location.X);
+	const VectorRegister LocationY = VectorSetFloat1(Location.Y);
+	const VectorRegister LocationZ = VectorSetFloat1(Location.Z);
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister LaneStep = VectorSetFloat1(4.f);
+
+	// Every lane keeps its own minimum and index of it, lanes are reduced once at the end
+	VectorRegister MinDistances = VectorSetFloat1(MAX_flt);
+	VectorRegister MinLanes = VectorSetFloat1(-1.f);
+	VectorRegister Lanes = MakeVectorRegister(0.f, 1.f, 2.f, 3.f);
+
+	for (int32 Lane = 0; Lane < LanesNum; Lane += 4)
+	{
+		const VectorRegister DeltaX = VectorSubtract(VectorLoadAligned(X + Lane), LocationX);
+		const VectorRegister DeltaY = VectorSubtract(VectorLoadAligned(Y + Lane), LocationY);
+		const VectorRegister DeltaZ = VectorSubtract(VectorLoadAligned(Z + Lane), LocationZ);
+
+		VectorRegister Distances = VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiplyAdd(DeltaY, DeltaY, VectorMultiply(DeltaZ, DeltaZ)));
+		Distances = VectorSelect(VectorCompareGT(VectorLoadAligned(CustomMasks + Lane), Zero), VectorLoadAligned(CustomDistances + Lane), Distances);
+		Distances = VectorAdd(Distances, VectorLoadAligned(Penalties + Lane));
+
+		const VectorRegister Closer = VectorCompareLT(Distances, MinDistances);
+		MinDistances = VectorSelect(Closer, Distances, MinDistances);
+		MinLanes = VectorSelect(Closer, Lanes, MinLanes);
+		Lanes = VectorAdd(Lanes, LaneStep);
+	}
+
+	MS_ALIGN(16) float LaneDistances[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float LaneIndices[4] GCC_ALIGN(16);
+	VectorStoreAligned(MinDistances, LaneDistances);
+	VectorStoreAligned(MinLanes, LaneIndices);
+
+	int32 ClosestLane = INDEX_NONE;
+	float ClosestDistance = MAX_flt;
+	for (int32 Lane = 0; Lane < 4; ++Lane)
+	{
+		if (LaneDistances[Lane] < ClosestDistance)
+		{
+			ClosestDistance = LaneDistances[Lane];
+			ClosestLane = static_cast<int32>(LaneIndices[Lane]);
+		}
+	}
+
+	return ClosestLane;
+}
@@ -0,0 +1,69 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class AVRMotionControllerHand;
+class IHandInteractable;
+
+/**
+ * IHandInteractable actors that one hand may grab, stored as structure of arrays with reference count of overlapping components per actor and O(1) lookup by actor. Closest candidate is found by one vectorized pass over grab point positions (see FindClosest).
+ * C++ implementers are asked through Native* virtuals of IHandInteractable. Blueprint GetWorldSquaredDistanceToMotionController is called only for actors that opt in with UsesCustomGrabDistance(), IsGrabDisabled excludes the actor.
+ * Everyone else is measured from its UVRGrabPointComponent (or actor location) to the hand natively. Grab point lanes persist between calls and are recomputed only for actors that moved
+ */
+class PROJECTVRBASICS_API FVRGrabCandidateTable
+{
+public:
+	// Every overlapping component of an actor adds a reference. True if actor was added (first reference) or removed (last reference)
+	bool AddReference(AActor* Actor);
+	bool RemoveReference(const AActor* Actor);
+	void Reset();
+
+	int32 Num() const { return Actors.Num(); }
+	int32 Find(const AActor* Actor) const;
+	AActor* GetActor(int32 Index) const { return Actors[Index].Get(); }
+	// Destroyed actors are dropped first, so OutActors has same order as indices of FindClosest()
+	void GetActors(TArray<AActor*>& OutActors);
+
+	// Index of the closest candidate that is not grab disabled, INDEX_NONE if there is none. Without bAskBlueprints only native checks are done (measured distance and Native* virtuals), so it is cheap enough to be called every tick
+	int32 FindClosest(const AVRMotionControllerHand* Hand, const FVector& HandLocation, bool bAskBlueprints);
+	// Some candidate opted in to Blueprint distance, so native only result may differ from the full one
+	bool HasBlueprintDistances() const { return BlueprintDistancesNum > 0; }
+
+private:
+	enum ECandidateFlags : uint8
+	{
+		BlueprintDistance = 1 << 0 // UsesCustomGrabDistance() returned true
+	};
+
+	void RemoveAt(int32 Index);
+	// Destroyed actors may not send end overlap. Called before indices are handed out, so every index refers to a valid actor
+	void RemoveDestroyed();
+
+	// Lanes are padded to a multiple of 4 with candidates that never win. Rebuilt when candidates are added or removed, otherwise only moved actors update their lane
+	void RefreshLanes(const AVRMotionControllerHand* Hand, bool bAskBlueprints);
+	void RebuildLanes();
+	void UpdateGrabPointLane(int32 Index, const AActor* Actor);
+	static int32 FindClosestLane(const float* X, const float* Y, const float* Z, const float* CustomDistances, const float* CustomMasks, const float* Penalties, int32 LanesNum, const FVector& Location);
+
+	TArray<TWeakObjectPtr<AActor>> Actors;
+	TArray<const AActor*> Keys; // Address actor was added with, stays valid as a key after actor is destroyed
+	TArray<FVector> LocalGrabPoints;
+	TArray<uint8> Flags;
+	TArray<IHandInteractable*> NativeInterfaces; // Null for actors that implement IHandInteractable in Blueprint only
+	TArray<int32> ReferenceCounts;
+	TMap<const AActor*, int32> Indices;
+	int32 BlueprintDistancesNum = 0;
+
+	// Lanes of FindClosest
+	bool bLanesDirty = true;
+	TArray<FTransform> LaneActorTransforms; // Actor transform grab point lane was computed with
+	TArray<float, TAlignedHeapAllocator<16>> PositionsX;
+	TArray<float, TAlignedHeapAllocator<16>> PositionsY;
+	TArray<float, TAlignedHeapAllocator<16>> PositionsZ;
+	TArray<float, TAlignedHeapAllocator<16>> CustomDistances; // Asked every call, custom distance may depend on anything
+	TArray<float, TAlignedHeapAllocator<16>> CustomMasks; // 1 if CustomDistances is used instead of measured distance
+	TArray<float, TAlignedHeapAllocator<16>> Penalties; // 0 or MAX_flt for disabled, destroyed and padding lanes
+};
@@ -6,6 +6,7 @@
 #include "UObject/NoExportTypes.h"
 
 #include "../Actors/Interfaces/VRPlayerInput.h"
+#include "../Input/VRGestureRecognizer.h"
 
 #include "ControllerState.generated.h"
 
@@ -40,6 +41,9 @@ public:
 	void OnStateEnter();
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "Controller State")
 	void OnStateExit();
+	// Called by owning motion controller when one of its enabled gestures is recognized (see FVRGestureSettings)
+	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "Controller State")
+	void OnGesture(const FVRGestureEvent& Gesture);
 
 	UFUNCTION(BlueprintCallable, Category = "Controller State")
 	AActor* SpawnActor(TSubclassOf<AActor> ClassToSpawn);
@@ -0,0 +1,281 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRInteractableGrid.h"
+
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Components/PrimitiveComponent.h"
+#include "HAL/IConsoleManager.h"
+
+#include "../Actors/Interfaces/VRInterfaceCache.h"
+
+
+namespace VRInteractableGrid
+{
+	static TAutoConsoleVariable<float> CVarCellSize(
+		TEXT("vr.InteractableGridCellSize"),
+		50.f,
+		TEXT("Cell size of UVRInteractableGrid in cm, about the size of hand grab sphere. Read when grid is activated"));
+
+	// Actors bigger than this count of cells are tested by every query instead of being added to every cell they cover
+	static const int32 MaxEntryCells = 64;
+}
+
+void UVRInteractableGrid::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UWorld* World = GetWorld();
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UVRInteractableGrid::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UVRInteractableGrid::OnLevelAddedToWorld);
+}
+
+void UVRInteractableGrid::Deinitialize()
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	for (FInteractableEntry& Entry : Entries)
+	{
+		if (Entry.Root.IsValid()) Entry.Root->TransformUpdated.RemoveAll(this);
+		if (Entry.Actor.IsValid()) Entry.Actor->OnEndPlay.RemoveDynamic(this, &UVRInteractableGrid::OnInteractableEndPlay);
+	}
+	Entries.Empty();
+	EntryIndices.Empty();
+	Cells.Empty();
+	OversizedEntries.Empty();
+	SpawnedActors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UVRInteractableGrid::Activate(const UPrimitiveComponent* GrabSphere)
+{
+	if (bActive) return;
+	bActive = true;
+
+	GrabSphereObjectType = GrabSphere->GetCollisionObjectType();
+	GrabSphereResponses = GrabSphere->GetCollisionResponseToChannels();
+
+	CellSize = FMath::Max(1.f, VRInteractableGrid::CVarCellSize.GetValueOnGameThread());
+
+	// Levels that were loaded with the world do not broadcast LevelAddedToWorld
+	for (ULevel* Level : GetWorld()->GetLevels()) RegisterLevelActors(Level);
+}
+
+void UVRInteractableGrid::RegisterInteractable(AActor* Actor)
+{
+	if (!Actor || EntryIndices.Contains(Actor)) return;
+
+	FInteractableEntry Entry;
+	Entry.Actor = Actor;
+	Entry.Key = Actor;
+	Entry.Root = Actor->GetRootComponent();
+	const int32 EntryIndex = Entries.Add(Entry);
+	EntryIndices.Add(Actor, EntryIndex);
+
+	// Physics simulated and attached roots broadcast it too, so entry is rehashed only when actor actually moves
+	if (Entry.Root.IsValid()) Entry.Root->TransformUpdated.AddUObject(this, &UVRInteractableGrid::OnRootTransformUpdated);
+	Actor->OnEndPlay.AddDynamic(this, &UVRInteractableGrid::OnInteractableEndPlay);
+
+	UpdateEntry(EntryIndex);
+}
+
+void UVRInteractableGrid::UnregisterInteractable(AActor* Actor)
+{
+	const int32* EntryIndex = EntryIndices.Find(Actor);
+	if (!EntryIndex) return;
+
+	FInteractableEntry& Entry = Entries[*EntryIndex];
+	if (Entry.Root.IsValid()) Entry.Root->TransformUpdated.RemoveAll(this);
+	if (Entry.Actor.IsValid()) Entry.Actor->OnEndPlay.RemoveDynamic(this, &UVRInteractableGrid::OnInteractableEndPlay);
+
+	RemoveEntry(*EntryIndex);
+}
+
+void UVRInteractableGrid::UpdateInteractableBounds(AActor* Actor)
+{
+	if (const int32* EntryIndex = EntryIndices.Find(Actor)) UpdateEntry(*EntryIndex);
+}
+
+void UVRInteractableGrid::QuerySphere(const FVector& Center, float Radius, TArray<AActor*>& OutActors)
+{
+	OutActors.Reset();
+	RegisterSpawnedActors();
+	++QueryStamp;
+
+	auto TestEntry = [this, &Center, Radius, &OutActors](int32 EntryIndex)
+	{
+		FInteractableEntry& Entry = Entries[EntryIndex];
+		if (Entry.QueryStamp == QueryStamp) return;
+		Entry.QueryStamp = QueryStamp;
+
+		AActor* Actor = Entry.Actor.Get();
+		if (Actor && FMath::SphereAABBIntersection(Center, Radius * Radius, Entry.Bounds)) OutActors.Add(Actor);
+	};
+
+	const FIntVector CellMin = GetCell(Center - FVector(Radius));
+	const FIntVector CellMax = GetCell(Center + FVector(Radius));
+
+	for (int32 X = CellMin.X; X <= CellMax.X; ++X)
+	{
+		for (int32 Y = CellMin.Y; Y <= CellMax.Y; ++Y)
+		{
+			for (int32 Z = CellMin.Z; Z <= CellMax.Z; ++Z)
+			{
+				const TArray<int32, TInlineAllocator<4>>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell) continue;
+
+				for (int32 EntryIndex : *Cell) TestEntry(EntryIndex);
+			}
+		}
+	}
+
+	for (int32 EntryIndex : OversizedEntries) TestEntry(EntryIndex);
+}
+
+void UVRInteractableGrid::OnActorSpawned(AActor* Actor)
+{
+	if (bActive && Actor && FVRInterfaceCache::Implements(Actor, EVRInterface::HandInteractable)) SpawnedActors.Add(Actor);
+}
+
+void UVRInteractableGrid::RegisterSpawnedActors()
+{
+	for (int32 Index = SpawnedActors.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = SpawnedActors[Index].Get();
+		if (Actor && !Actor->IsActorInitialized()) continue; // FinishSpawning was not called yet
+
+		if (Actor) RegisterInteractable(Actor);
+		SpawnedActors.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+void UVRInteractableGrid::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (bActive && World == GetWorld()) RegisterLevelActors(Level);
+}
+
+void UVRInteractableGrid::RegisterLevelActors(ULevel* Level)
+{
+	if (!Level) return;
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor && FVRInterfaceCache::Implements(Actor, EVRInterface::HandInteractable)) RegisterInteractable(Actor);
+	}
+}
+
+void UVRInteractableGrid::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (const int32* EntryIndex = EntryIndices.Find(UpdatedComponent->GetOwner())) UpdateEntry(*EntryIndex);
+}
+
+void UVRInteractableGrid::OnInteractableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterInteractable(Actor); // Destroyed or its level was streamed out
+}
+
+void UVRInteractableGrid::UpdateEntry(int32 EntryIndex)
+{
+	FInteractableEntry& Entry = Entries[EntryIndex];
+	AActor* Actor = Entry.Actor.Get();
+	if (!Actor) return;
+
+	Entry.Bounds = FBox(ForceInit);
+	TInlineComponentArray<UPrimitiveComponent*> Components(Actor);
+	for (const UPrimitiveComponent* Component : Components)
+	{
+		if (Component->IsRegistered() && CollidesWithGrabSphere(Component)) Entry.Bounds += Component->Bounds.GetBox();
+	}
+
+	if (!Entry.Bounds.IsValid)
+	{
+		RemoveFromCells(EntryIndex); // Nothing that could overlap the sphere
+		return;
+	}
+
+	const FIntVector CellMin = GetCell(Entry.Bounds.Min);
+	const FIntVector CellMax = GetCell(Entry.Bounds.Max);
+	if (Entry.bInCells && CellMin == Entry.CellMin && CellMax == Entry.CellMax) return; // Moved inside the same cells
+
+	RemoveFromCells(EntryIndex);
+	Entry.CellMin = CellMin;
+	Entry.CellMax = CellMax;
+	AddToCells(EntryIndex);
+}
+
+void UVRInteractableGrid::AddToCells(int32 EntryIndex)
+{
+	FInteractableEntry& Entry = Entries[EntryIndex];
+	Entry.bInCells = true;
+
+	const FIntVector CellsNum = Entry.CellMax - Entry.CellMin + FIntVector(1);
+	Entry.bOversized = CellsNum.X * CellsNum.Y * CellsNum.Z > VRInteractableGrid::MaxEntryCells;
+	if (Entry.bOversized)
+	{
+		OversizedEntries.Add(EntryIndex);
+		return;
+	}
+
+	for (int32 X = Entry.CellMin.X; X <= Entry.CellMax.X; ++X)
+	{
+		for (int32 Y = Entry.CellMin.Y; Y <= Entry.CellMax.Y; ++Y)
+		{
+			for (int32 Z = Entry.CellMin.Z; Z <= Entry.CellMax.Z; ++Z) Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(EntryIndex);
+		}
+	}
+}
+
+void UVRInteractableGrid::RemoveFromCells(int32 EntryIndex)
+{
+	FInteractableEntry& Entry = Entries[EntryIndex];
+	if (!Entry.bInCells) return;
+	Entry.bInCells = false;
+
+	if (Entry.bOversized)
+	{
+		OversizedEntries.RemoveSingleSwap(EntryIndex, false);
+		Entry.bOversized = false;
+		return;
+	}
+
+	for (int32 X = Entry.CellMin.X; X <= Entry.CellMax.X; ++X)
+	{
+		for (int32 Y = Entry.CellMin.Y; Y <= Entry.CellMax.Y; ++Y)
+		{
+			for (int32 Z = Entry.CellMin.Z; Z <= Entry.CellMax.Z; ++Z)
+			{
+				const FIntVector CellKey(X, Y, Z);
+				TArray<int32, TInlineAllocator<4>>* Cell = Cells.Find(CellKey);
+				if (!Cell) continue;
+
+				Cell->RemoveSingleSwap(EntryIndex, false);
+				if (Cell->Num() == 0) Cells.Remove(CellKey);
+			}
+		}
+	}
+}
+
+void UVRInteractableGrid::RemoveEntry(int32 EntryIndex)
+{
+	RemoveFromCells(EntryIndex);
+
+	EntryIndices.Remove(Entries[EntryIndex].Key);
+	Entries.RemoveAt(EntryIndex);
+}
+
+bool UVRInteractableGrid::CollidesWithGrabSphere(const UPrimitiveComponent* Component) const
+{
+	// Same collision conditions as overlap with the sphere, but overlap events do not have to be generated
+	if (!Component->IsQueryCollisionEnabled()) return false;
+	if (Component->GetCollisionResponseToChannel(GrabSphereObjectType) == ECR_Ignore) return false;
+
+	return GrabSphereResponses.GetResponse(Component->GetCollisionObjectType()) != ECR_Ignore;
+}
+
+FIntVector UVRInteractableGrid::GetCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
@@ -0,0 +1,89 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Components/SceneComponent.h"
+
+#include "VRInteractableGrid.generated.h"
+
+class ULevel;
+
+/**
+ * Uniform spatial hash of collision bounds of every actor that implements IHandInteractable. Hands that use it (AVRMotionControllerHand::bUseInteractableGrid) query it each tick instead of generating overlap events with their grab sphere.
+ * Actors are registered automatically once some hand activates the grid: when spawned (on first query after their construction finished) or when their level is added to the world. Actor is rehashed only when its root component moves (vr.InteractableGridCellSize).
+ * Bounds of an actor include only components with query collision that neither ignores nor is ignored by the grab sphere the grid was activated with. Changes of their collision settings at runtime need UpdateInteractableBounds().
+ * Generate Overlap Events is not needed, so interactables that are grabbed only by grid hands may turn it off on their components and stop paying for overlap updates
+ */
+UCLASS()
+class PROJECTVRBASICS_API UVRInteractableGrid : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Registers loaded interactables and starts tracking new ones. Called by hands that use the grid, collision settings of the first GrabSphere filter components of interactables
+	void Activate(const UPrimitiveComponent* GrabSphere);
+
+	// Only needed for actors that start or stop implementing IHandInteractable at runtime
+	UFUNCTION(BlueprintCallable, Category = "VR Interactable Grid")
+	void RegisterInteractable(AActor* Actor);
+	UFUNCTION(BlueprintCallable, Category = "VR Interactable Grid")
+	void UnregisterInteractable(AActor* Actor);
+	// Actor changed its bounds without moving its root component (f.e. component was added or moved relative to root, or its collision changed)
+	UFUNCTION(BlueprintCallable, Category = "VR Interactable Grid")
+	void UpdateInteractableBounds(AActor* Actor);
+
+	// Actors whose bounds intersect the sphere. OutActors is reset
+	void QuerySphere(const FVector& Center, float Radius, TArray<AActor*>& OutActors);
+
+private:
+	struct FInteractableEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		const AActor* Key = nullptr; // Address actor was registered with in EntryIndices
+		TWeakObjectPtr<USceneComponent> Root; // Its TransformUpdated is bound
+		FBox Bounds = FBox(ForceInit);
+		FIntVector CellMin = FIntVector::ZeroValue;
+		FIntVector CellMax = FIntVector::ZeroValue;
+		bool bInCells = false;
+		bool bOversized = false; // Covers too many cells, so it is tested by every query instead
+		uint32 QueryStamp = 0; // Entry spans several cells but is tested once per query
+	};
+
+	void OnActorSpawned(AActor* Actor);
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void RegisterLevelActors(ULevel* Level);
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	UFUNCTION()
+	void OnInteractableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+	// Deferred spawns (every Blueprint SpawnActor node) broadcast spawn before construction script created their components
+	void RegisterSpawnedActors();
+	bool CollidesWithGrabSphere(const UPrimitiveComponent* Component) const;
+
+	void UpdateEntry(int32 EntryIndex);
+	void AddToCells(int32 EntryIndex);
+	void RemoveFromCells(int32 EntryIndex);
+	void RemoveEntry(int32 EntryIndex);
+	FIntVector GetCell(const FVector& Location) const;
+
+	TSparseArray<FInteractableEntry> Entries; // Indices stay valid while other entries are removed
+	TMap<const AActor*, int32> EntryIndices;
+	TMap<FIntVector, TArray<int32, TInlineAllocator<4>>> Cells;
+	TArray<int32> OversizedEntries;
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors; // Not registered until their construction is finished
+
+	// Collision of grab sphere, so grid has same components as overlap events would have
+	TEnumAsByte<ECollisionChannel> GrabSphereObjectType = ECC_WorldDynamic;
+	FCollisionResponseContainer GrabSphereResponses;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+
+	float CellSize = 50.f;
+	uint32 QueryStamp = 0;
+	bool bActive = false;
+};
@@ -0,0 +1,241 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRPointableRegistry.h"
+
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+#include "../Actors/Interfaces/ControllerPointable.h"
+#include "../Actors/Interfaces/VRInterfaceCache.h"
+#include "../Actors/ActorComponents/VRPointingProxyComponent.h"
+
+
+void UVRPointableRegistry::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UWorld* World = GetWorld();
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UVRPointableRegistry::OnActorSpawned));
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UVRPointableRegistry::OnLevelAddedToWorld);
+}
+
+void UVRPointableRegistry::Deinitialize()
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	GetWorld()->GetTimerManager().ClearTimer(SpawnedActorsTimerHandle);
+
+	for (const FPointableEntry& Entry : Entries) UnbindEntry(Entry);
+	Entries.Empty();
+	EntryIndices.Empty();
+	SpawnedActors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UVRPointableRegistry::RegisterPointable(AActor* Actor)
+{
+	if (!Actor || FindEntry(Actor) != INDEX_NONE) return;
+
+	if (const int32* StaleIndex = EntryIndices.Find(Actor)) RemoveEntryAt(*StaleIndex); // Destroyed actor had the same address
+
+	EntryIndices.Add(Actor, Entries.Num());
+	FPointableEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Actor = Actor;
+	Entry.Key = Actor;
+	Entry.Root = Actor->GetRootComponent();
+	UpdateEntryBounds(Entry);
+
+	// Physics simulated and attached roots broadcast it too, so bounds are refreshed only when actor actually moves
+	if (Entry.Root.IsValid()) Entry.Root->TransformUpdated.AddUObject(this, &UVRPointableRegistry::OnRootTransformUpdated);
+	Actor->OnEndPlay.AddDynamic(this, &UVRPointableRegistry::OnPointableEndPlay);
+
+	if (bPointingProxiesEnabled) CreatePointingProxies(Entry);
+}
+
+void UVRPointableRegistry::UnregisterPointable(AActor* Actor)
+{
+	const int32 Index = FindEntry(Actor);
+	if (Index == INDEX_NONE) return;
+
+	UnbindEntry(Entries[Index]);
+	DestroyPointingProxies(Entries[Index]);
+	RemoveEntryAt(Index);
+}
+
+void UVRPointableRegistry::UpdatePointableBounds(AActor* Actor)
+{
+	const int32 Index = FindEntry(Actor);
+	if (Index != INDEX_NONE) UpdateEntryBounds(Entries[Index]);
+}
+
+int32 UVRPointableRegistry::FindEntry(const AActor* Actor) const
+{
+	const int32* Index = EntryIndices.Find(Actor);
+	return Index && Entries[*Index].Actor.Get() == Actor ? *Index : INDEX_NONE;
+}
+
+void UVRPointableRegistry::RemoveEntryAt(int32 Index)
+{
+	const int32 LastIndex = Entries.Num() - 1;
+
+	EntryIndices.Remove(Entries[Index].Key);
+	if (Index != LastIndex) EntryIndices.Add(Entries[LastIndex].Key, Index); // Last one is swapped into the removed slot
+
+	Entries.RemoveAtSwap(Index, 1, false);
+}
+
+void UVRPointableRegistry::OnActorSpawned(AActor* Actor)
+{
+	if (!Actor || !FVRInterfaceCache::Implements(Actor, EVRInterface::ControllerPointable)) return;
+
+	if (Actor->IsActorInitialized())
+	{
+		RegisterPointable(Actor);
+		return;
+	}
+
+	// Without components its bounds are empty and no pointing proxies could be created
+	SpawnedActors.Add(Actor);
+	if (!SpawnedActorsTimerHandle.IsValid()) SpawnedActorsTimerHandle = GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UVRPointableRegistry::RegisterSpawnedActors);
+}
+
+void UVRPointableRegistry::RegisterSpawnedActors()
+{
+	SpawnedActorsTimerHandle.Invalidate();
+
+	for (int32 Index = SpawnedActors.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = SpawnedActors[Index].Get();
+		if (Actor && !Actor->IsActorInitialized()) continue; // FinishSpawning was not called yet
+
+		if (Actor) RegisterPointable(Actor);
+		SpawnedActors.RemoveAtSwap(Index, 1, false);
+	}
+
+	if (SpawnedActors.Num() > 0) SpawnedActorsTimerHandle = GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UVRPointableRegistry::RegisterSpawnedActors);
+}
+
+void UVRPointableRegistry::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld()) RegisterLevelActors(Level);
+}
+
+void UVRPointableRegistry::RegisterLevelActors(ULevel* Level)
+{
+	if (!Level) return;
+
+	for (AActor* Actor : Level->Actors)
+	{
+		if (Actor && FVRInterfaceCache::Implements(Actor, EVRInterface::ControllerPointable)) RegisterPointable(Actor);
+	}
+}
+
+void UVRPointableRegistry::RegisterLoadedLevels()
+{
+	// Levels that were loaded with the world do not broadcast LevelAddedToWorld, so they are registered on first use
+	if (bLevelsRegistered) return;
+	bLevelsRegistered = true;
+
+	for (ULevel* Level : GetWorld()->GetLevels()) RegisterLevelActors(Level);
+}
+
+void UVRPointableRegistry::OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	UpdatePointableBounds(UpdatedComponent->GetOwner());
+}
+
+void UVRPointableRegistry::OnPointableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterPointable(Actor); // Destroyed or its level was streamed out
+}
+
+void UVRPointableRegistry::UnbindEntry(const FPointableEntry& Entry)
+{
+	if (Entry.Root.IsValid()) Entry.Root->TransformUpdated.RemoveAll(this);
+	if (Entry.Actor.IsValid()) Entry.Actor->OnEndPlay.RemoveDynamic(this, &UVRPointableRegistry::OnPointableEndPlay);
+}
+
+void UVRPointableRegistry::UpdateEntryBounds(FPointableEntry& Entry)
+{
+	AActor* Actor = Entry.Actor.Get();
+	if (!Actor) return;
+
+	FVector Origin;
+	FVector BoxExtent;
+	Actor->GetActorBounds(true, Origin, BoxExtent); // Only colliding components may be hit by a trace
+
+	Entry.Center = Origin;
+	Entry.Radius = BoxExtent.Size();
+}
+
+bool UVRPointableRegistry::HasPointableInCone(const FVector& Origin, const FVector& Direction, float MaxDistance, float ConeHalfAngleDegrees)
+{
+	RegisterLoadedLevels();
+
+	const float ConeTan = FMath::Tan(FMath::DegreesToRadians(ConeHalfAngleDegrees));
+
+	for (const FPointableEntry& Entry : Entries)
+	{
+		const FVector ToCenter = Entry.Center - Origin;
+		const float AlongDistance = FVector::DotProduct(ToCenter, Direction);
+
+		if (AlongDistance < -Entry.Radius || AlongDistance > MaxDistance + Entry.Radius) continue; // Behind or too far
+
+		// Sphere intersects the cone if distance from the axis is less than cone radius at that distance plus sphere radius
+		const float AllowedDistance = FMath::Max(AlongDistance, 0.f) * ConeTan + Entry.Radius;
+		const float SquaredAxisDistance = ToCenter.SizeSquared() - AlongDistance * AlongDistance;
+
+		if (SquaredAxisDistance <= AllowedDistance * AllowedDistance) return true;
+	}
+
+	return false;
+}
+
+void UVRPointableRegistry::SetPointingProxiesEnabled(bool bEnabled)
+{
+	if (bPointingProxiesEnabled == bEnabled) return;
+	bPointingProxiesEnabled = bEnabled;
+
+	RegisterLoadedLevels();
+
+	for (FPointableEntry& Entry : Entries)
+	{
+		if (bEnabled) CreatePointingProxies(Entry);
+		else DestroyPointingProxies(Entry);
+	}
+}
+
+void UVRPointableRegistry::CreatePointingProxies(FPointableEntry& Entry)
+{
+	AActor* Actor = Entry.Actor.Get();
+	if (!Actor || Entry.Proxies.Num() > 0) return;
+
+	// Actor with proxies added by hand defines its pointable shape itself
+	if (Actor->FindComponentByClass<UVRPointingProxyComponent>()) return;
+
+	TInlineComponentArray<UPrimitiveComponent*> Components(Actor);
+	for (UPrimitiveComponent* Component : Components)
+	{
+		// Only components that full collision pointing trace (BlockAll) could hit. Components that block VRPointing themselves (f.e. widgets) need no proxy
+		if (!Component->IsQueryCollisionEnabled()) continue;
+		if (Component->GetCollisionResponseToChannel(ECC_WorldStatic) != ECR_Block) continue;
+		if (Component->GetCollisionResponseToChannel(ECC_VRPointing) == ECR_Block) continue;
+
+		UVRPointingProxyComponent* Proxy = NewObject<UVRPointingProxyComponent>(Actor, NAME_None, RF_Transient);
+		Proxy->SetSourceComponent(Component);
+		Proxy->RegisterComponent();
+		Entry.Proxies.Add(Proxy);
+	}
+}
+
+void UVRPointableRegistry::DestroyPointingProxies(FPointableEntry& Entry)
+{
+	for (const TWeakObjectPtr<UVRPointingProxyComponent>& Proxy : Entry.Proxies)
+	{
+		if (Proxy.IsValid()) Proxy->DestroyComponent();
+	}
+	Entry.Proxies.Reset();
+}
@@ -0,0 +1,82 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "Components/SceneComponent.h"
+
+#include "VRPointableRegistry.generated.h"
+
+class ULevel;
+class UVRPointingProxyComponent;
+
+/**
+ * Bounds of every actor that implements IControllerPointable. Motion controllers test their pointing cone against it and skip pointing trace if nothing pointable may be hit.
+ * Actors are registered automatically when spawned (after their construction is finished) or when their level is added to the world. Bounds are refreshed only when actor`s root component moves
+ */
+UCLASS()
+class PROJECTVRBASICS_API UVRPointableRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Only needed for actors that start or stop implementing IControllerPointable at runtime
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Registry")
+	void RegisterPointable(AActor* Actor);
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Registry")
+	void UnregisterPointable(AActor* Actor);
+	// Actor changed its bounds without moving its root component (f.e. component was added or moved relative to root, or its collision changed)
+	UFUNCTION(BlueprintCallable, Category = "VR Pointable Registry")
+	void UpdatePointableBounds(AActor* Actor);
+
+	// True if bounds of some pointable actor intersect a cone from Origin along Direction (normalized)
+	bool HasPointableInCone(const FVector& Origin, const FVector& Direction, float MaxDistance, float ConeHalfAngleDegrees);
+
+	// Pointable actors get simple proxies that block VRPointing channel (see UVRPointingProxyComponent). Enabled by motion controllers that point at proxies only
+	void SetPointingProxiesEnabled(bool bEnabled);
+
+private:
+	struct FPointableEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		const AActor* Key = nullptr; // Address actor was registered with in EntryIndices
+		TWeakObjectPtr<USceneComponent> Root; // Its TransformUpdated is bound
+		FVector Center = FVector::ZeroVector;
+		float Radius = 0.f;
+		TArray<TWeakObjectPtr<UVRPointingProxyComponent>, TInlineAllocator<2>> Proxies; // Generated by this registry only
+	};
+
+	void OnActorSpawned(AActor* Actor);
+	// Deferred spawns (every Blueprint SpawnActor node) broadcast spawn before construction script created their components, so they are registered next tick
+	void RegisterSpawnedActors();
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void RegisterLevelActors(ULevel* Level);
+	void RegisterLoadedLevels();
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	UFUNCTION()
+	void OnPointableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+	void UnbindEntry(const FPointableEntry& Entry);
+
+	int32 FindEntry(const AActor* Actor) const;
+	void RemoveEntryAt(int32 Index);
+
+	static void UpdateEntryBounds(FPointableEntry& Entry);
+	static void CreatePointingProxies(FPointableEntry& Entry);
+	static void DestroyPointingProxies(FPointableEntry& Entry);
+
+	TArray<FPointableEntry> Entries;
+	TMap<const AActor*, int32> EntryIndices; // So registering every actor of a loaded level is not quadratic
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors; // Waiting for their construction to finish
+	FTimerHandle SpawnedActorsTimerHandle;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+
+	bool bLevelsRegistered = false;
+	bool bPointingProxiesEnabled = false;
+};
@@ -0,0 +1,29 @@
+// Alex Smirnov 2020-2021
+
+
+#include "VRWidgetRedrawBudget.h"
+
+#include "HAL/IConsoleManager.h"
+
+
+namespace VRWidgetRedrawBudget
+{
+	static TAutoConsoleVariable<int32> CVarBudget(
+		TEXT("vr.WidgetRedrawBudget"),
+		2,
+		TEXT("Max count of world-space VR widgets that are not pointed at and get redrawn in one frame. See UVRWidgetRedrawBudget"));
+}
+
+bool UVRWidgetRedrawBudget::TryConsumeRedraw(bool bPriority)
+{
+	if (BudgetFrame != GFrameCounter)
+	{
+		BudgetFrame = GFrameCounter;
+		RedrawsThisFrame = 0;
+	}
+
+	if (!bPriority && RedrawsThisFrame >= VRWidgetRedrawBudget::CVarBudget.GetValueOnGameThread()) return false;
+
+	++RedrawsThisFrame;
+	return true;
+}
@@ -0,0 +1,26 @@
+// Alex Smirnov 2020-2021
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "VRWidgetRedrawBudget.generated.h"
+
+/**
+ * Limits how many world-space VR widgets are redrawn per frame (vr.WidgetRedrawBudget). Widgets that are pointed at are always redrawn but still use the budget,
+ * widgets that are not pointed at redraw at low rate or on content change only while budget lasts, the rest wait for next frame (see UVRPointableWidgetComponent)
+ */
+UCLASS()
+class PROJECTVRBASICS_API UVRWidgetRedrawBudget : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// True if widget may redraw this frame. Priority requests are always granted
+	bool TryConsumeRedraw(bool bPriority);
+
+private:
+	uint64 BudgetFrame = 0;
+	int32 RedrawsThisFrame = 0;
+};
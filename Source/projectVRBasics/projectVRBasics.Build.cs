@@ -14,6 +14,9 @@ public class projectVRBasics : ModuleRules
 
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
+
+		// Pointable world-space widgets (see UVRPointableWidgetComponent)
+		PrivateDependencyModuleNames.AddRange(new string[] { "UMG" });
 		
 		// Uncomment if you are using online features
 		// PrivateDependencyModuleNames.Add("OnlineSubsystem");